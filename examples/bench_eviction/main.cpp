@@ -0,0 +1,129 @@
+// Benchmarks cost-aware eviction with 10^6 cached assets: the victim
+// selection kernel on its own, and small, large and full cleanups under both
+// eviction policies.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/victim_selection.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+constexpr std::size_t ENTRY_COUNT = 1000000;
+constexpr std::size_t VICTIM_COUNT = 64;
+
+class Blob : public dynasma::PolymorphicBase {
+    std::size_t m_cost;
+
+  public:
+    Blob(std::size_t cost) : m_cost(cost) {}
+
+    std::size_t memory_cost() const { return m_cost; }
+};
+
+struct BlobSeed {
+    using Asset = Blob;
+    std::size_t kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+using Manager = dynasma::BasicManager<BlobSeed, std::allocator<Blob>>;
+
+const char *instructionSet() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE4_2__)
+    return "SSE4.2";
+#else
+    return "scalar";
+#endif
+}
+
+template <class F> double millisecondsOf(F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> took =
+        std::chrono::steady_clock::now() - start;
+    return took.count();
+}
+
+void benchKernel() {
+    std::mt19937 rng(42);
+    std::vector<std::uint32_t> weights(ENTRY_COUNT), lastUses(ENTRY_COUNT);
+    for (std::size_t i = 0; i < ENTRY_COUNT; i++) {
+        weights[i] = rng() % 65536 + 1;
+        lastUses[i] = (std::uint32_t)i;
+    }
+    std::uint32_t now = ENTRY_COUNT;
+
+    dynasma::Victim victims[VICTIM_COUNT];
+    std::size_t found;
+    double ms = millisecondsOf([&]() {
+        for (int rep = 0; rep < 10; rep++) {
+            found = dynasma::selectVictims(weights.data(), lastUses.data(),
+                                           ENTRY_COUNT, now, victims,
+                                           VICTIM_COUNT);
+        }
+    });
+
+    // check against a plain scan for the best victim
+    std::uint64_t bestScore = 0;
+    for (std::size_t i = 0; i < ENTRY_COUNT; i++) {
+        std::uint64_t score =
+            (std::uint64_t)(now - lastUses[i] + 1) * weights[i];
+        if (score > bestScore) {
+            bestScore = score;
+        }
+    }
+
+    std::cout << "selectVictims (" << instructionSet() << "): " << ms / 10
+              << " ms per scan of " << ENTRY_COUNT << " entries, found "
+              << found << " victims, best matches the plain scan: "
+              << (victims[0].score == bestScore) << std::endl;
+}
+
+void benchClean(dynasma::EvictionPolicy policy, const char *name) {
+    std::mt19937 rng(7);
+    Manager manager;
+    manager.set_eviction_policy(policy);
+
+    std::vector<dynasma::LazyPtr<Blob>> ptrs;
+    ptrs.reserve(ENTRY_COUNT);
+    for (std::size_t i = 0; i < ENTRY_COUNT; i++) {
+        ptrs.push_back(manager.register_asset_k(
+            (std::size_t)(rng() % 65536 + 1)));
+        ptrs.back().getLoaded(); // dropped right away, so it gets cached
+    }
+
+    std::size_t cachedBefore = manager.cached_count();
+    std::size_t freed;
+    double ms = millisecondsOf([&]() { freed = manager.clean(1 << 22); });
+
+    std::cout << name << " clean(4 MiB): " << ms << " ms, freed " << freed
+              << " bytes by unloading "
+              << cachedBefore - manager.cached_count() << " of "
+              << cachedBefore << " cached assets" << std::endl;
+
+    std::size_t half = manager.cached_memory() / 2;
+    ms = millisecondsOf([&]() { freed = manager.clean(half); });
+    std::cout << name << " clean(half): " << ms << " ms, freed " << freed
+              << " bytes" << std::endl;
+    ms = millisecondsOf([&]() { freed = manager.cleanAll(); });
+    std::cout << name << " cleanAll(): " << ms << " ms, freed " << freed
+              << " bytes" << std::endl;
+
+    ptrs.clear();
+    manager.cleanAll();
+}
+
+int main() {
+    benchKernel();
+    benchClean(dynasma::EvictionPolicy::Oldest, "Oldest");
+    benchClean(dynasma::EvictionPolicy::CostAware, "CostAware");
+
+    return 0;
+}
@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <optional>
+#include <stdexcept>
 
 class TestAsset : public dynasma::PolymorphicBase {
   public:
@@ -23,6 +24,56 @@ struct TestSeed {
     std::string name() const { return std::get<std::string>(kernel); }
 };
 
+// A seed with a plain kernel, constructed without any variant dispatch
+struct PlainSeed {
+    using Asset = TestAsset;
+    std::string kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+class NumberedAsset : public TestAsset {
+  public:
+    NumberedAsset(std::string name) : TestAsset(name) {}
+    NumberedAsset(int number) : TestAsset("#" + std::to_string(number)) {}
+};
+
+// A seed whose kernel picks one of several constructors
+struct ChoiceSeed {
+    using Asset = TestAsset;
+    std::variant<std::string, int> kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+// A seed whose kernel option is itself a variant, which is passed to the
+// constructor as is, so NumberedAsset can't be constructed from it
+struct NestedChoiceSeed {
+    using Asset = TestAsset;
+    std::variant<std::variant<std::string, int>, int> kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+// A kernel option whose construction throws, and whose move may throw,
+// so a failed emplace leaves the kernel valueless
+struct FailingName {
+    struct Fail {};
+    std::string name;
+
+    FailingName(Fail) { throw std::runtime_error("no name"); }
+    FailingName(const FailingName &) = default;
+    FailingName(FailingName &&other) noexcept(false) : name(other.name) {}
+    operator std::string() const { return name; }
+};
+
+struct FallibleSeed {
+    using Asset = TestAsset;
+    std::variant<std::string, FailingName> kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
 // A function taking template template parameter Manager that tests it
 template <template <typename, typename> typename Manager> void testManager() {
     Manager<TestSeed, std::allocator<TestAsset>> manager;
@@ -79,6 +130,96 @@ template <template <typename, typename> typename Manager> void testManager() {
     std::cout << "Cleaned!\n";
 }
 
+void testGracePeriod() {
+    dynasma::NaiveManager<TestSeed, std::allocator<TestAsset>> manager;
+    manager.set_grace_period(2);
+
+    auto lazyPtr = manager.register_asset_k("<Per-frame asset>");
+
+    for (int frame = 0; frame < 3; frame++) {
+        std::cout << "    Frame " << frame << "\n";
+        auto firmPtr = lazyPtr.getLoaded(); // loaded only in the first frame
+        manager.tick();
+    }
+
+    std::cout << "    Unused from now on\n";
+    for (int frame = 3; frame < 6; frame++) {
+        std::cout << "    Frame " << frame << "\n";
+        manager.tick(); // unloaded after 2 ticks
+    }
+
+    auto olderPtr = manager.register_asset_k("<Released earlier>");
+    auto newerPtr = manager.register_asset_k("<Released later>");
+    {
+        auto newerFirm = newerPtr.getLoaded();
+        olderPtr.getLoaded();
+        manager.tick();
+    }
+    manager.clean(1); // the earlier released one goes first
+    std::cout << "    After cleaning 1 byte, earlier one loaded: "
+              << olderPtr.try_get().has_value()
+              << ", later one loaded: " << newerPtr.try_get().has_value()
+              << "\n";
+    manager.cleanAll();
+}
+
+void testFrameEpochs() {
+    dynasma::BasicManager<TestSeed, std::allocator<TestAsset>> manager;
+    manager.set_frame_epochs(true);
+
+    auto lazyPtr = manager.register_asset_k("<Hot asset>");
+
+    for (int i = 0; i < 1000; i++) {
+        // released and re-held many times, moved to cached only once
+        auto firmPtr = lazyPtr.getLoaded();
+    }
+    std::cout << "    Cleaning before end of frame freed "
+              << manager.cleanAll() << " bytes\n";
+
+    manager.end_frame();
+    std::cout << "    Cleaning after end of frame freed "
+              << manager.cleanAll() << " bytes\n";
+}
+
+void testKernelKinds() {
+    dynasma::BasicManager<PlainSeed, std::allocator<TestAsset>> plainManager;
+    auto plainPtr = plainManager.register_asset_k("<Plain kernel asset>");
+    plainPtr.getLoaded();
+    std::cout << "    sizeof(PlainSeed): " << sizeof(PlainSeed)
+              << ", sizeof(TestSeed): " << sizeof(TestSeed) << "\n";
+
+    dynasma::BasicManager<ChoiceSeed, std::allocator<NumberedAsset>>
+        choiceManager;
+    auto namedPtr = choiceManager.register_asset_k("<Named asset>");
+    auto numberedPtr = choiceManager.register_asset_k(42);
+    namedPtr.getLoaded();
+    numberedPtr.getLoaded();
+
+    plainManager.cleanAll();
+    choiceManager.cleanAll();
+
+    std::cout << "    Nested variant kernel accepted: "
+              << dynasma::SeededAllocatorLike<std::allocator<NumberedAsset>,
+                                              NestedChoiceSeed>
+              << "\n";
+
+    FallibleSeed fallibleSeed{std::string("<Never named asset>")};
+    try {
+        fallibleSeed.kernel.emplace<FailingName>(FailingName::Fail{});
+    } catch (const std::runtime_error &) {
+    }
+    dynasma::BasicManager<FallibleSeed, std::allocator<TestAsset>>
+        fallibleManager;
+    auto valuelessPtr =
+        fallibleManager.register_asset(std::move(fallibleSeed));
+    try {
+        valuelessPtr.getLoaded();
+    } catch (const std::bad_variant_access &) {
+        std::cout << "    valueless kernel rejected, loaded: "
+                  << valuelessPtr.try_get().has_value() << "\n";
+    }
+}
+
 int main() {
     std::cout << "==== TESTING NaiveManager ==== " << std::endl;
     testManager<dynasma::NaiveManager>();
@@ -86,5 +227,15 @@ int main() {
     std::cout << "==== TESTING BasicManager ==== " << std::endl;
     testManager<dynasma::BasicManager>();
 
+    std::cout << "==== TESTING NaiveManager grace period ==== " << std::endl;
+    testGracePeriod();
+
+    std::cout << "==== TESTING BasicManager frame epochs ==== " << std::endl;
+    testFrameEpochs();
+
+    std::cout << "==== TESTING plain and multi-option kernels ==== "
+              << std::endl;
+    testKernelKinds();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+// Demonstrates FirmRef: functions that only use an asset for the duration of
+// a call take a borrowed reference, so passing FirmPtrs and PinPtrs to them
+// doesn't touch the reference counts.
+
+#include "dynasma/borrow.hpp"
+#include "dynasma/pin.hpp"
+#include "dynasma/pointer.hpp"
+#include "dynasma/standalone.hpp"
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct Vertex {
+    float x, y;
+};
+
+struct Mesh : public dynasma::PolymorphicBase {
+    std::string name;
+    std::vector<Vertex> outline;
+
+    Mesh(std::string name, std::vector<Vertex> outline)
+        : name(std::move(name)), outline(std::move(outline)) {}
+
+    std::size_t memory_cost() const { return sizeof(Mesh); }
+};
+
+// Shoelace formula; only needs the mesh during the call
+float area(dynasma::FirmRef<const Mesh> mesh) {
+    float sum = 0.0f;
+    for (std::size_t i = 0; i < mesh->outline.size(); i++) {
+        const Vertex &a = mesh->outline[i];
+        const Vertex &b = mesh->outline[(i + 1) % mesh->outline.size()];
+        sum += a.x * b.y - b.x * a.y;
+    }
+    return sum / 2.0f;
+}
+
+std::size_t vertexCount(dynasma::FirmRef<const std::vector<Vertex>> outline) {
+    return outline->size();
+}
+
+int main() {
+    std::vector<dynasma::FirmPtr<Mesh>> meshes;
+    meshes.push_back(dynasma::makeStandalone<Mesh>(
+        "square", std::vector<Vertex>{{0, 0}, {2, 0}, {2, 2}, {0, 2}}));
+    meshes.push_back(dynasma::makeStandalone<Mesh>(
+        "triangle", std::vector<Vertex>{{0, 0}, {4, 0}, {0, 3}}));
+
+    // no hold()/release() pair per call
+    float total = 0.0f;
+    for (int frame = 0; frame < 1000; frame++) {
+        for (const auto &mesh : meshes) {
+            total += area(mesh);
+        }
+    }
+    std::cout << "Total area over 1000 frames: " << total << std::endl;
+
+    // borrowing a pinned sub-object
+    dynasma::PinPtr<Mesh> pinnedMesh = meshes[1];
+    dynasma::PinPtr<std::vector<Vertex>> pinnedOutline{pinnedMesh,
+                                                       pinnedMesh->outline};
+    std::cout << "Triangle vertices: " << vertexCount(pinnedOutline)
+              << std::endl;
+
+    // a borrow can be turned into an owning pointer when it must be kept
+    dynasma::FirmRef<Mesh> borrowed = dynasma::borrow(meshes[0]);
+    dynasma::PinPtr<Mesh> kept = borrowed.pin();
+    std::cout << "Kept mesh: " << kept->name << std::endl;
+
+    // borrowing monadic operations of the nullable pointers
+    std::optional<dynasma::FirmPtr<Mesh>> maybeMesh = meshes[0];
+    std::optional<dynasma::FirmPtr<Mesh>> noMesh;
+    auto describe = [](dynasma::FirmRef<Mesh> mesh) { return mesh->name; };
+    std::cout << "Optional mesh: "
+              << maybeMesh.transform_borrowed(describe).value_or("<none>")
+              << ", empty optional: "
+              << noMesh.transform_borrowed(describe).value_or("<none>")
+              << std::endl;
+
+    return 0;
+}
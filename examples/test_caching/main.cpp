@@ -75,7 +75,25 @@ int main() {
                   << std::endl;
     }
 
+    std::cout << "Cached assets: " << cacher.cached_count() << ", "
+              << cacher.cached_memory() << " bytes" << std::endl;
+
     cacher.clean(1000000);
 
+    {
+        // opportunistic access: never stalls on a load
+        auto lazyPtr = cacher.retrieve_asset(TestSeed{"<My asset 3>"});
+        std::cout << "Available before loading: "
+                  << lazyPtr.try_get().has_value() << std::endl;
+
+        lazyPtr.getLoaded();
+        std::cout << "Available while cached: "
+                  << lazyPtr.try_get().has_value() << std::endl;
+
+        cacher.clean(1000000);
+        std::cout << "Available after cleaning: "
+                  << lazyPtr.try_get().has_value() << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
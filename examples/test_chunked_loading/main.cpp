@@ -0,0 +1,107 @@
+// Demonstrates chunked construction: a large mesh is read chunk by chunk
+// through a bounded double buffer, and a load cancelled between chunks
+// leaves the asset unloaded.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/chunked.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <span>
+#include <stop_token>
+
+// generates `size` bytes of mesh data, as if read from a file
+struct MeshReader {
+    std::size_t size;
+    std::size_t offset = 0;
+
+    std::size_t read(std::span<std::byte> buffer) {
+        std::size_t n = std::min(buffer.size(), size - offset);
+        for (std::size_t i = 0; i < n; i++) {
+            buffer[i] = std::byte((offset + i) % 251);
+        }
+        offset += n;
+        return n;
+    }
+};
+
+struct OpenMesh {
+    std::size_t size;
+    MeshReader operator()() const { return MeshReader{size}; }
+};
+
+// when set, the player leaves the level after the first loaded chunk
+std::stop_source *p_leaving_level = nullptr;
+
+class Mesh : public dynasma::PolymorphicBase {
+    std::size_t m_size;
+    std::size_t m_checksum;
+
+  public:
+    struct Builder {
+        std::size_t size = 0;
+        std::size_t checksum = 0;
+        std::size_t chunks = 0;
+
+        void consume(std::span<const std::byte> chunk) {
+            for (std::byte b : chunk) {
+                checksum += std::to_integer<std::size_t>(b);
+            }
+            size += chunk.size();
+            chunks++;
+            std::cout << "  consumed chunk " << chunks << std::endl;
+            if (p_leaving_level) {
+                p_leaving_level->request_stop();
+            }
+        }
+    };
+
+    Mesh(Builder &&builder)
+        : m_size(builder.size), m_checksum(builder.checksum) {}
+
+    std::size_t size() const { return m_size; }
+    std::size_t checksum() const { return m_checksum; }
+
+    std::size_t memory_cost() const { return sizeof(Mesh); }
+};
+
+struct MeshSeed {
+    using Asset = Mesh;
+    dynasma::ChunkedSource<OpenMesh> kernel;
+
+    std::size_t load_cost() const { return kernel.open.size; }
+};
+
+int main() {
+    dynasma::BasicManager<MeshSeed, std::allocator<Mesh>> meshes;
+
+    std::cout << "Loading a 10000 byte mesh in 4096 byte chunks:" << std::endl;
+    auto terrain = meshes.register_asset_k(
+        dynasma::ChunkedSource<OpenMesh>{OpenMesh{10000}, 4096});
+    {
+        dynasma::FirmPtr<Mesh> p_terrain = terrain.getLoaded();
+        std::cout << "Loaded " << p_terrain->size() << " bytes, checksum "
+                  << p_terrain->checksum() << std::endl;
+    }
+
+    std::cout << "Loading a mesh cancelled while reading:" << std::endl;
+    std::stop_source cancel;
+    p_leaving_level = &cancel;
+    auto cave = meshes.register_asset_k(dynasma::ChunkedSource<OpenMesh>{
+        OpenMesh{10000}, 4096, cancel.get_token()});
+    try {
+        cave.getLoaded();
+        std::cout << "Unexpectedly loaded" << std::endl;
+        return 1;
+    } catch (const dynasma::LoadCancelled &e) {
+        std::cout << e.what() << std::endl;
+    }
+    std::cout << "Cave is loaded: " << cave.try_get().has_value()
+              << std::endl;
+
+    meshes.cleanAll();
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Demonstrates ConcurrentCacher: many threads retrieve and use the same
+// assets, taking no locks once they are loaded, while another thread keeps
+// cleaning the unused ones.
+// Built with DYNASMA_CONCURRENT_COUNTERS defined.
+
+#include "dynasma/cachers/concurrent.hpp"
+#include "dynasma/core_concepts.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::atomic<int> loadCount{0};
+
+class Config : public dynasma::PolymorphicBase {
+    std::string m_name;
+
+  public:
+    Config(std::string name) : m_name(name) { loadCount++; }
+
+    const std::string &name() const { return m_name; }
+
+    std::size_t memory_cost() const { return sizeof(Config); }
+};
+
+struct ConfigSeed {
+    using Asset = Config;
+    std::string kernel;
+
+    std::size_t load_cost() const { return 1; }
+
+    bool operator==(const ConfigSeed &other) const = default;
+    bool operator<(const ConfigSeed &other) const {
+        return kernel < other.kernel;
+    }
+};
+
+template <> struct std::hash<ConfigSeed> {
+    std::size_t operator()(const ConfigSeed &seed) const {
+        return std::hash<std::string>{}(seed.kernel);
+    }
+};
+
+using Cacher = dynasma::ConcurrentCacher<ConfigSeed, std::allocator<Config>>;
+
+constexpr int READER_COUNT = 8;
+constexpr int KEY_COUNT = 200;
+constexpr int ITERATIONS = 20000;
+
+int main() {
+    Cacher cacher;
+
+    // a few assets stay loaded for the whole run, as hot entries would
+    std::vector<dynasma::FirmPtr<Config>> pinned;
+    for (int i = 0; i < 10; i++) {
+        pinned.push_back(
+            cacher.retrieve_asset_k("config_" + std::to_string(i)).getLoaded());
+    }
+
+    std::atomic<bool> running{true};
+    std::atomic<long> mismatches{0};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < READER_COUNT; t++) {
+        readers.emplace_back([&, t]() {
+            for (int i = 0; i < ITERATIONS; i++) {
+                std::string name =
+                    "config_" + std::to_string((i * 7 + t) % KEY_COUNT);
+                auto firm = cacher.retrieve_asset_k(name).getLoaded();
+                dynasma::FirmPtr<Config> copy = firm;
+                if (copy->name() != name) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+
+    std::thread cleaner([&]() {
+        while (running) {
+            cacher.clean(sizeof(Config) * 50);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    running = false;
+    cleaner.join();
+
+    std::cout << "Retrievals: " << READER_COUNT * ITERATIONS
+              << ", mismatched assets: " << mismatches << std::endl;
+    std::cout << "Loads (reloads after cleanup included): " << loadCount
+              << std::endl;
+
+    pinned.clear();
+    cacher.cleanAll();
+    std::cout << "Registered seeds after cleaning: " << cacher.size()
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Demonstrates content-addressed sharing: two cachers (or two seeds in one
+// cacher) that produce equal assets end up sharing a single instance, and its
+// memory is freed (and reported by clean()) only once.
+
+#include "dynasma/cachers/basic.hpp"
+#include "dynasma/cachers/content_table.hpp"
+#include "dynasma/core_concepts.hpp"
+
+#include <functional>
+#include <iostream>
+
+class Texture : public dynasma::PolymorphicBase {
+    std::string m_pixels;
+
+  public:
+    // Both "a.png" and "copy_of_a.png" decode to the same pixels
+    Texture(std::string path)
+        : m_pixels(path.find("a.png") != std::string::npos ? "AAAA" : "BBBB") {
+        std::cout << "--- Texture " << path << " loaded" << std::endl;
+    }
+    ~Texture() { std::cout << "--- Texture destructed" << std::endl; }
+
+    const std::string &pixels() const { return m_pixels; }
+
+    std::size_t memory_cost() const { return sizeof(Texture); }
+
+    std::size_t content_hash() const {
+        return std::hash<std::string>{}(m_pixels);
+    }
+    bool operator==(const Texture &other) const {
+        return m_pixels == other.m_pixels;
+    }
+};
+
+struct TextureSeed {
+    using Asset = Texture;
+    std::variant<std::string> kernel;
+
+    std::size_t load_cost() const { return 1; }
+    std::string path() const { return std::get<std::string>(kernel); }
+
+    bool operator<(const TextureSeed &other) const {
+        return path() < other.path();
+    }
+};
+
+int main() {
+    dynasma::ContentTable<Texture> table;
+    dynasma::BasicCacher<TextureSeed, std::allocator<Texture>> cacherA, cacherB;
+    cacherA.set_content_table(table);
+    cacherB.set_content_table(table);
+
+    {
+        auto a = cacherA.retrieve_asset_k("a.png").getLoaded();
+        auto copy = cacherA.retrieve_asset_k("copy_of_a.png").getLoaded();
+        auto other = cacherB.retrieve_asset_k("textures/a.png").getLoaded();
+        auto b = cacherB.retrieve_asset_k("b.png").getLoaded();
+
+        std::cout << "a === copy: " << (&*a == &*copy) << std::endl;
+        std::cout << "a === other: " << (&*a == &*other) << std::endl;
+        std::cout << "a === b: " << (&*a == &*b) << std::endl;
+        std::cout << "Distinct resident textures: " << table.size()
+                  << std::endl;
+    }
+
+    std::size_t freed = 0;
+    do {
+        freed = cacherA.cleanAll() + cacherB.cleanAll();
+        std::cout << "Cleaned " << freed << " bytes" << std::endl;
+    } while (freed > 0);
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+// Demonstrates cost-aware eviction: clean() unloads the cached assets with
+// the highest memory cost multiplied by the time since their last use first,
+// and skips the victims that an earlier victim's destructor forgot.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class Blob : public dynasma::PolymorphicBase {
+    std::string m_name;
+    std::size_t m_cost;
+    // the assets this one keeps registered while it is loaded
+    std::vector<dynasma::LazyPtr<Blob>> m_dependencies;
+
+  public:
+    struct Desc {
+        std::string name;
+        std::size_t cost;
+        // LazyPtrs handed over to the blob on construction
+        std::vector<dynasma::LazyPtr<Blob>> *p_adopted = nullptr;
+    };
+
+    Blob(const Desc &desc) : m_name(desc.name), m_cost(desc.cost) {
+        if (desc.p_adopted) {
+            m_dependencies = std::move(*desc.p_adopted);
+            desc.p_adopted->clear();
+        }
+    }
+    ~Blob() { std::cout << "--- " << m_name << " unloaded" << std::endl; }
+
+    std::size_t memory_cost() const { return m_cost; }
+};
+
+struct BlobSeed {
+    using Asset = Blob;
+    Blob::Desc kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+using Manager = dynasma::BasicManager<BlobSeed, std::allocator<Blob>>;
+
+void testVictimOrder() {
+    Manager manager;
+    manager.set_eviction_policy(dynasma::EvictionPolicy::CostAware);
+
+    // the big one goes first even though it was released recently, as it
+    // frees the most
+    auto smallOld = manager.register_asset_k(Blob::Desc{"small old", 10});
+    auto medium = manager.register_asset_k(Blob::Desc{"medium", 100});
+    auto bigRecent = manager.register_asset_k(Blob::Desc{"big recent", 1000});
+    for (auto *p_ptr : {&smallOld, &medium, &bigRecent}) {
+        p_ptr->getLoaded();
+    }
+    // used again, so it is the youngest
+    smallOld.getLoaded();
+
+    std::cout << "Cleaning 500 of " << manager.cached_memory() << " bytes"
+              << std::endl;
+    std::size_t freed = manager.clean(500);
+    std::cout << "Freed " << freed << " bytes, small one still loaded: "
+              << smallOld.try_get().has_value()
+              << ", medium one still loaded: " << medium.try_get().has_value()
+              << std::endl;
+
+    std::cout << "Cleaning everything" << std::endl;
+    manager.cleanAll();
+}
+
+void testDependentVictims() {
+    Manager manager;
+    manager.set_eviction_policy(dynasma::EvictionPolicy::CostAware);
+
+    std::vector<dynasma::LazyPtr<Blob>> handover;
+    handover.push_back(manager.register_asset_k(Blob::Desc{"part", 1}));
+    handover.back().getLoaded();
+    auto whole = manager.register_asset_k(
+        Blob::Desc{"whole", 100000, &handover});
+    // the whole now holds the only LazyPtr to the part
+    whole.getLoaded();
+    auto other = manager.register_asset_k(Blob::Desc{"other", 2});
+    other.getLoaded();
+
+    // the whole goes first and forgets the part, which was selected next
+    std::cout << "Cleaning 100002 of " << manager.cached_memory() << " bytes"
+              << std::endl;
+    std::size_t freed = manager.clean(100002);
+    std::cout << "Freed " << freed << " bytes, other one still loaded: "
+              << other.try_get().has_value() << std::endl;
+}
+
+int main() {
+    std::cout << "==== TESTING victim order ==== " << std::endl;
+    testVictimOrder();
+
+    std::cout << "==== TESTING victims forgotten by other victims ==== "
+              << std::endl;
+    testDependentVictims();
+
+    return 0;
+}
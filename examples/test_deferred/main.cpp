@@ -0,0 +1,119 @@
+// Demonstrates time-sliced cleanup: clean_for() and IncrementalCleaner free
+// memory in bounded slices, and a DestructionQueue moves the asset
+// destructors off the cleaning thread, or off the thread that dropped the
+// last pointer.
+
+#include "dynasma/cleaner.hpp"
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/keepers/naive.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/deferred_destruction.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+class SlowAsset : public dynasma::PolymorphicBase {
+  public:
+    SlowAsset(int) {}
+    ~SlowAsset() {
+        // pretend to release a large GPU buffer
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::size_t memory_cost() const { return 1000; }
+};
+
+struct SlowSeed {
+    using Asset = SlowAsset;
+    std::variant<int> kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+using Manager = dynasma::BasicManager<SlowSeed, std::allocator<SlowAsset>>;
+
+// a destruction that only records which object it was run for
+void recordDestruction(void *p_order, void *p_object) {
+    static_cast<std::vector<int> *>(p_order)->push_back(
+        *static_cast<int *>(p_object));
+}
+
+void loadAll(std::vector<dynasma::LazyPtr<SlowAsset>> &ptrs) {
+    for (auto &ptr : ptrs) {
+        ptr.getLoaded();
+    }
+}
+
+int main() {
+    using namespace std::chrono_literals;
+
+    Manager manager;
+    std::vector<dynasma::LazyPtr<SlowAsset>> ptrs;
+    for (int i = 0; i < 20; i++) {
+        ptrs.push_back(manager.register_asset_k(i));
+    }
+    loadAll(ptrs);
+
+    std::cout << "== clean_for(3ms) ==" << std::endl;
+    std::size_t freed = manager.clean_for(3ms);
+    std::cout << "Freed " << freed << " bytes in the first slice" << std::endl;
+
+    std::cout << "== IncrementalCleaner ==" << std::endl;
+    dynasma::IncrementalCleaner cleaner{&manager};
+    cleaner.request_all();
+    int steps = 0;
+    while (!cleaner.done()) {
+        cleaner.step(2ms);
+        steps++;
+    }
+    std::cout << "Cleaned everything in " << steps << " slices" << std::endl;
+
+    std::cout << "== DestructionQueue worker ==" << std::endl;
+    dynasma::DestructionQueue queue;
+    queue.start_worker();
+    manager.set_destruction_queue(queue);
+    loadAll(ptrs);
+
+    auto start = std::chrono::steady_clock::now();
+    freed = manager.cleanAll();
+    auto took = std::chrono::steady_clock::now() - start;
+    std::cout << "Freed " << freed << " bytes, clean() took "
+              << (took < 5ms ? "less than" : "more than") << " 5ms"
+              << std::endl;
+
+    queue.stop_worker();
+    std::cout << "Pending destructions after stopping the worker: "
+              << queue.size() << std::endl;
+
+    std::cout << "== Batched destruction of released keeper assets =="
+              << std::endl;
+    dynasma::NaiveKeeper<SlowSeed, std::allocator<SlowAsset>> keeper;
+    keeper.set_destruction_queue(queue);
+    for (int i = 0; i < 5; i++) {
+        // dropped right away, as a per-frame temporary would be
+        keeper.new_asset_k(i).getLoaded();
+    }
+    std::cout << "Queued after the frame: " << queue.size() << std::endl;
+    std::cout << "Drained between frames: " << queue.drain() << std::endl;
+
+    std::cout << "== Time-sliced draining order ==" << std::endl;
+    std::vector<int> order;
+    int objects[] = {0, 1, 2};
+    for (int &object : objects) {
+        queue.push(&recordDestruction, &order, &object);
+    }
+    queue.drain_for(0ms); // runs one
+    queue.drain();
+    std::cout << "Destroyed in order:";
+    for (int i : order) {
+        std::cout << " " << i;
+    }
+    std::cout << std::endl;
+
+    ptrs.clear();
+    manager.cleanAll();
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Demonstrates deferred forgetting: a scene change drops the LazyPtrs to all
+// of a level's tiles. Instead of erasing each tile's seed from the cacher's
+// index right away, the entries are marked and swept together by compact().
+
+#include "dynasma/cachers/basic.hpp"
+#include "dynasma/core_concepts.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+class Tile : public dynasma::PolymorphicBase {
+    int m_id;
+
+  public:
+    Tile(int id) : m_id(id) {}
+
+    int id() const { return m_id; }
+
+    std::size_t memory_cost() const { return sizeof(Tile); }
+};
+
+struct TileSeed {
+    using Asset = Tile;
+    int kernel;
+
+    std::size_t load_cost() const { return 1; }
+    bool operator<(const TileSeed &other) const {
+        return kernel < other.kernel;
+    }
+};
+
+using TileCacher = dynasma::BasicCacher<TileSeed, std::allocator<Tile>>;
+
+constexpr int TILE_COUNT = 200000;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// registers a level's tiles, then drops them all
+double changeScene(TileCacher &tiles) {
+    std::vector<dynasma::LazyPtr<Tile>> level;
+    for (int i = 0; i < TILE_COUNT; i++) {
+        level.push_back(tiles.retrieve_asset_k(i));
+    }
+    auto start = std::chrono::steady_clock::now();
+    level.clear();
+    return millisecondsSince(start);
+}
+
+int main() {
+    TileCacher immediate;
+    double immediateMs = changeScene(immediate);
+    std::cout << "Immediate: forgot " << TILE_COUNT << " tiles in "
+              << immediateMs << " ms" << std::endl;
+
+    TileCacher deferred;
+    deferred.set_deferred_forgetting(true);
+    double dropMs = changeScene(deferred);
+    std::cout << "Deferred: marked " << deferred.marked_count() << " in "
+              << dropMs << " ms" << std::endl;
+
+    {
+        // remembered again before the sweep, so it survives it
+        dynasma::LazyPtr<Tile> kept = deferred.retrieve_asset_k(42);
+
+        auto start = std::chrono::steady_clock::now();
+        deferred.compact();
+        std::cout << "Deferred: swept in " << millisecondsSince(start)
+                  << " ms, " << deferred.marked_count() << " still marked"
+                  << std::endl;
+
+        bool survived = kept.getLoaded()->id() == 42 &&
+                        deferred.retrieve_asset_k(42) == kept;
+        std::cout << "Remembered tile survived: " << survived << std::endl;
+    }
+
+    // the tiles dropped later, and the cached one, get swept by clean()
+    for (int i = 0; i < 10; i++) {
+        deferred.retrieve_asset_k(i);
+    }
+    std::cout << "Marked before cleaning: " << deferred.marked_count()
+              << std::endl;
+    deferred.cleanAll();
+    std::cout << "Marked after cleaning: " << deferred.marked_count()
+              << std::endl;
+
+    deferred.cleanAll();
+    return 0;
+}
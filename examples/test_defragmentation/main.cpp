@@ -0,0 +1,95 @@
+// Demonstrates incremental defragmentation: after many load and unload
+// cycles with assets held at random, the dense storage is full of holes.
+// A few cached assets are moved into them each frame, until the storage is
+// packed again and its emptied chunks are freed.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/dense_storage.hpp"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+class Decal : public dynasma::PolymorphicBase {
+    int m_id;
+
+  public:
+    Decal(int id) : m_id(id) {}
+
+    int id() const { return m_id; }
+
+    std::size_t memory_cost() const { return 1; }
+};
+
+struct DecalSeed {
+    using Asset = Decal;
+    int kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+constexpr int DECAL_COUNT = 1000;
+
+void printStats(const char *when, const dynasma::DenseStorage<Decal> &storage) {
+    dynasma::FragmentationStats stats = storage.fragmentation();
+    std::printf("%s: %zu decals spanning %zu of %zu slots, %.0f%% holes\n",
+                when, stats.objects, stats.spanned_slots, stats.capacity,
+                stats.ratio() * 100);
+}
+
+int main() {
+    dynasma::DenseStorage<Decal> storage;
+    dynasma::BasicManager<DecalSeed, dynasma::DenseStorage<Decal>> decals(
+        storage);
+
+    std::vector<dynasma::LazyPtr<Decal>> lazyDecals;
+    for (int i = 0; i < DECAL_COUNT; i++) {
+        lazyDecals.push_back(decals.register_asset_k(i));
+    }
+
+    // load everything, then keep a random tenth of the decals in use, which
+    // pins them in place
+    std::mt19937 rng(42);
+    std::vector<dynasma::FirmPtr<Decal>> visible;
+    {
+        std::vector<dynasma::FirmPtr<Decal>> all;
+        for (auto &decal : lazyDecals) {
+            all.push_back(decal.getLoaded());
+        }
+        for (int i = 0; i < DECAL_COUNT; i++) {
+            if (rng() % 10 == 0) {
+                visible.push_back(all[i]);
+            }
+        }
+    }
+    // the used decals block the compaction on unload, leaving holes
+    decals.clean(DECAL_COUNT / 2);
+    printStats("Fragmented", storage);
+
+    // defragmentation moves only cached decals from the end, so it's
+    // blocked while the last decal is in use
+    std::printf("Moved while in use: %zu\n", decals.defragment());
+
+    // once the decals go off screen, they can be moved
+    visible.clear();
+    int frame = 0;
+    while (decals.defragment(64) > 0) {
+        frame++;
+    }
+    printStats("Defragmented", storage);
+    std::printf("Took %d frames\n", frame);
+
+    bool intact = true;
+    for (int i = 0; i < DECAL_COUNT; i++) {
+        if (auto decal = lazyDecals[i].try_get()) {
+            intact &= (*decal)->id() == i;
+        }
+    }
+    std::printf("Intact: %d\n", intact);
+
+    decals.cleanAll();
+    printStats("Cleaned", storage);
+
+    return 0;
+}
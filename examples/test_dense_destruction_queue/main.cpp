@@ -0,0 +1,102 @@
+// Demonstrates dense storage with deferred destruction: unloaded animations
+// wait in the queue while still occupying their slots. They aren't visited
+// by for_each_loaded(), nor mistaken for the animations loaded again later,
+// nor moved by defragment().
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/deferred_destruction.hpp"
+#include "dynasma/util/dense_storage.hpp"
+
+#include <iostream>
+#include <set>
+#include <vector>
+
+class Animation : public dynasma::PolymorphicBase {
+    int m_id;
+
+  public:
+    Animation(int id) : m_id(id) {}
+
+    int id() const { return m_id; }
+
+    std::size_t memory_cost() const { return 1; }
+};
+
+struct AnimationSeed {
+    using Asset = Animation;
+    int kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+constexpr int ANIMATION_COUNT = 10;
+
+using AnimationManager =
+    dynasma::BasicManager<AnimationSeed, dynasma::DenseStorage<Animation>>;
+
+// whether each loaded animation is visited once, and has the right id
+bool visitsLoaded(AnimationManager &animations,
+                  std::vector<dynasma::LazyPtr<Animation>> &lazyAnimations) {
+    std::set<int> visited;
+    bool unique = true;
+    animations.for_each_loaded([&](Animation &animation) {
+        unique &= visited.insert(animation.id()).second;
+    });
+    std::size_t loaded = 0;
+    for (int i = 0; i < ANIMATION_COUNT; i++) {
+        if (auto animation = lazyAnimations[i].try_get()) {
+            unique &= (*animation)->id() == i && visited.count(i) == 1;
+            loaded++;
+        }
+    }
+    return unique && visited.size() == loaded;
+}
+
+int main() {
+    dynasma::DenseStorage<Animation> storage;
+    dynasma::DestructionQueue queue;
+    AnimationManager animations(storage);
+    animations.set_destruction_queue(queue);
+
+    std::vector<dynasma::LazyPtr<Animation>> lazyAnimations;
+    for (int i = 0; i < ANIMATION_COUNT; i++) {
+        lazyAnimations.push_back(animations.register_asset_k(i));
+        lazyAnimations.back().getLoaded();
+    }
+
+    // the 3 oldest wait in the queue, still in their slots
+    animations.clean(3);
+    std::cout << "Queued 3, stored " << storage.size() << ", visits loaded: "
+              << visitsLoaded(animations, lazyAnimations) << std::endl;
+
+    // loaded again while its old instance is still queued, then cached
+    lazyAnimations[0].getLoaded();
+    std::cout << "Reloaded 0, stored " << storage.size()
+              << ", visits loaded: "
+              << visitsLoaded(animations, lazyAnimations) << std::endl;
+
+    // the queued instances still take their slots, leaving no holes yet
+    std::size_t moved = animations.defragment();
+    std::cout << "Defragmented before draining, moved " << moved
+              << ", visits loaded: "
+              << visitsLoaded(animations, lazyAnimations) << std::endl;
+
+    queue.drain();
+    std::cout << "Drained, stored " << storage.size() << ", visits loaded: "
+              << visitsLoaded(animations, lazyAnimations) << std::endl;
+
+    // the last cached animations move into the freed slots
+    moved = animations.defragment();
+    std::cout << "Defragmented, moved " << moved << ", "
+              << storage.fragmentation().spanned_slots
+              << " slots spanned, visits loaded: "
+              << visitsLoaded(animations, lazyAnimations) << std::endl;
+
+    lazyAnimations.clear();
+    animations.cleanAll();
+    queue.drain();
+    std::cout << "After cleaning: stored " << storage.size() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Demonstrates dense storage: animations are packed in chunks and updated
+// each frame with for_each_loaded(). Unloading some of them moves cached
+// animations into the holes, while the ones in use stay in place.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/dense_storage.hpp"
+
+#include <iostream>
+#include <vector>
+
+class Animation : public dynasma::PolymorphicBase {
+    int m_id;
+    float m_time;
+
+  public:
+    Animation(int id) : m_id(id), m_time(0) {}
+
+    int id() const { return m_id; }
+    float time() const { return m_time; }
+    void advance(float dt) { m_time += dt; }
+
+    std::size_t memory_cost() const { return 1; }
+};
+
+struct AnimationSeed {
+    using Asset = Animation;
+    int kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+constexpr int ANIMATION_COUNT = 130;
+
+int main() {
+    dynasma::DenseStorage<Animation> storage;
+    dynasma::BasicManager<AnimationSeed, dynasma::DenseStorage<Animation>>
+        animations(storage);
+
+    std::vector<dynasma::LazyPtr<Animation>> lazyAnimations;
+    std::vector<dynasma::FirmPtr<Animation>> playing;
+    for (int i = 0; i < ANIMATION_COUNT; i++) {
+        lazyAnimations.push_back(animations.register_asset_k(i));
+        playing.push_back(lazyAnimations.back().getLoaded());
+    }
+    std::cout << "Stored " << storage.size() << " in " << storage.capacity()
+              << " slots" << std::endl;
+
+    // the first third keeps playing, the rest become cached
+    std::vector<dynasma::FirmPtr<Animation>> stillPlaying(
+        playing.begin(), playing.begin() + ANIMATION_COUNT / 3);
+    playing.clear();
+
+    for (int frame = 0; frame < 3; frame++) {
+        animations.for_each_loaded(
+            [](Animation &animation) { animation.advance(0.5f); });
+    }
+
+    // unload the oldest 40 cached animations, leaving holes in the middle of
+    // the storage that the last cached ones move into
+    animations.clean(40);
+    std::cout << "After unloading 40: stored " << storage.size() << ", cached "
+              << animations.cached_count() << std::endl;
+
+    // the animations in use weren't moved, the moved ones kept their state
+    bool intact = true;
+    for (auto &animation : stillPlaying) {
+        intact &= animation->time() == 1.5f;
+    }
+    int visited = 0;
+    animations.for_each_loaded([&](Animation &animation) {
+        intact &= animation.time() == 1.5f;
+        visited++;
+    });
+    for (int i = 0; i < ANIMATION_COUNT; i++) {
+        if (auto animation = lazyAnimations[i].try_get()) {
+            intact &= (*animation)->id() == i;
+        }
+    }
+    std::cout << "Visited " << visited << ", intact: " << intact << std::endl;
+
+    std::cout << "Slots 40 to 47:";
+    int position = 0;
+    storage.for_each([&](Animation &animation, void *) {
+        if (position >= 40 && position < 48) {
+            std::cout << " " << animation.id();
+        }
+        position++;
+    });
+    std::cout << std::endl;
+
+    stillPlaying.clear();
+    animations.cleanAll();
+    std::cout << "After cleaning: stored " << storage.size() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Demonstrates fallback assets: materials are drawn with a placeholder
+// texture until their own textures are streamed in, one per frame, and
+// notice the switch through the pointer's version.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/fallback.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/standalone.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class Texture : public dynasma::PolymorphicBase {
+    std::string m_name;
+
+  public:
+    Texture(std::string name) : m_name(name) {}
+
+    const std::string &name() const { return m_name; }
+
+    std::size_t memory_cost() const { return sizeof(Texture); }
+};
+
+struct TextureSeed {
+    using Asset = Texture;
+    std::string kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+int main() {
+    dynasma::BasicManager<TextureSeed, std::allocator<Texture>> textures;
+    textures.set_fallback(dynasma::makeStandalone<Texture>("checkerboard"));
+
+    std::vector<dynasma::LazyPtr<Texture>> requested;
+    std::vector<dynasma::FallbackPtr<Texture>> drawn;
+    std::vector<std::size_t> seenVersions;
+    for (std::string name : {"brick", "grass", "water"}) {
+        requested.push_back(textures.register_asset_k(name));
+        drawn.push_back(textures.with_fallback(requested.back()));
+        seenVersions.push_back(drawn.back().version());
+    }
+
+    // the streaming side, loading one texture per frame
+    std::vector<dynasma::FirmPtr<Texture>> streamed;
+
+    for (int frame = 0; frame < 4; frame++) {
+        std::cout << "Frame " << frame << ":";
+        for (std::size_t i = 0; i < drawn.size(); i++) {
+            std::cout << " " << drawn[i]->name();
+            if (drawn[i].version() != seenVersions[i]) {
+                seenVersions[i] = drawn[i].version();
+                std::cout << " (switched)";
+            }
+        }
+        std::cout << std::endl;
+
+        if (streamed.size() < requested.size()) {
+            streamed.push_back(requested[streamed.size()].getLoaded());
+        }
+    }
+
+    drawn.clear();
+    streamed.clear();
+    textures.cleanAll();
+
+    return 0;
+}
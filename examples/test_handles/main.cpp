@@ -0,0 +1,88 @@
+// Demonstrates compact handles: components store 4-byte LazyHandle /
+// FirmHandle values instead of LazyPtr / FirmPtr, resolved through a
+// HandleTable. Stale handles are detected instead of dangling.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/handle.hpp"
+#include "dynasma/managers/basic.hpp"
+
+#include <iostream>
+#include <vector>
+
+class Mesh : public dynasma::PolymorphicBase {
+    std::string m_name;
+
+  public:
+    Mesh(std::string name) : m_name(name) {
+        std::cout << "--- Mesh " << name << " loaded" << std::endl;
+    }
+    ~Mesh() { std::cout << "--- Mesh " << m_name << " unloaded" << std::endl; }
+
+    const std::string &name() const { return m_name; }
+
+    std::size_t memory_cost() const { return sizeof(Mesh); }
+};
+
+struct MeshSeed {
+    using Asset = Mesh;
+    std::variant<std::string> kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+// An entity component referencing an asset
+struct RenderComponent {
+    dynasma::FirmHandle<Mesh> mesh;
+};
+
+int main() {
+    dynasma::BasicManager<MeshSeed, std::allocator<Mesh>> manager;
+
+    {
+        dynasma::HandleTable<Mesh> meshes;
+
+        std::cout << "sizeof(LazyPtr): " << sizeof(dynasma::LazyPtr<Mesh>)
+                  << ", sizeof(LazyHandle): "
+                  << sizeof(dynasma::LazyHandle<Mesh>) << std::endl;
+        std::cout << "sizeof(FirmPtr): " << sizeof(dynasma::FirmPtr<Mesh>)
+                  << ", sizeof(FirmHandle): "
+                  << sizeof(dynasma::FirmHandle<Mesh>) << std::endl;
+
+        auto rock = meshes.insert(manager.register_asset_k("rock"));
+        auto tree = meshes.insert(manager.register_asset_k("tree"));
+
+        std::vector<RenderComponent> components;
+        for (int i = 0; i < 3; i++) {
+            components.push_back({meshes.firm(rock)});
+        }
+        components.push_back({meshes.firm(tree)});
+
+        for (const RenderComponent &c : components) {
+            std::cout << "Drawing " << meshes[c.mesh].name() << std::endl;
+        }
+
+        // converting back to a regular pointer at an API boundary
+        dynasma::FirmPtr<Mesh> treePtr = *meshes.firm_ptr(components[3].mesh);
+        std::cout << "Tree through FirmPtr: " << treePtr->name() << std::endl;
+
+        for (const RenderComponent &c : components) {
+            meshes.release(c.mesh);
+        }
+        meshes.erase(rock);
+
+        std::cout << "Rock handle still valid: " << meshes.valid(rock)
+                  << std::endl;
+        std::cout << "Stale firm handle resolves to nullptr: "
+                  << (meshes.get(components[0].mesh) == nullptr) << std::endl;
+
+        // the freed slot is reused with a new generation
+        auto bush = meshes.insert(manager.register_asset_k("bush"));
+        std::cout << "Bush reuses the rock's slot: "
+                  << (bush.index() == rock.index()) << ", equal handles: "
+                  << (bush == rock) << std::endl;
+    }
+
+    manager.cleanAll();
+
+    return 0;
+}
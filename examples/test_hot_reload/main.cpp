@@ -0,0 +1,88 @@
+// Demonstrates hot reloading: a config asset is reloaded when its file
+// changes on disk. Pointers taken before the reload keep the old version
+// alive, new ones get the new version.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/file_watch.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+class Config : public dynasma::PolymorphicBase {
+    std::string m_text;
+
+  public:
+    Config(const std::string &path) {
+        std::ifstream file(path);
+        std::getline(file, m_text);
+        std::cout << "--- Config '" << m_text << "' loaded" << std::endl;
+    }
+    ~Config() {
+        std::cout << "--- Config '" << m_text << "' destructed" << std::endl;
+    }
+
+    const std::string &text() const { return m_text; }
+
+    std::size_t memory_cost() const { return sizeof(Config); }
+};
+
+struct ConfigSeed {
+    using Asset = Config;
+    std::string kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+void writeFile(const std::filesystem::path &path, const std::string &text) {
+    std::ofstream file(path, std::ios::trunc);
+    file << text << std::endl;
+}
+
+int main() {
+    std::filesystem::path dir =
+        std::filesystem::temp_directory_path() / "dynasma_hot_reload";
+    std::filesystem::create_directories(dir);
+    std::filesystem::path path = dir / "settings.txt";
+    writeFile(path, "vsync=on");
+
+    dynasma::BasicManager<ConfigSeed, std::allocator<Config>> configs;
+    dynasma::FileWatcher watcher;
+    watcher.watch(path, [&]() {
+        std::size_t n = configs.reload_if([&](const ConfigSeed &seed) {
+            return seed.kernel == path.string();
+        });
+        std::cout << "File changed, reloaded " << n << " asset(s)"
+                  << std::endl;
+    });
+
+    {
+        auto lazyConfig = configs.register_asset_k(path.string());
+        auto oldConfig = lazyConfig.getLoaded();
+        std::cout << "Version " << lazyConfig.version() << ": "
+                  << oldConfig->text() << std::endl;
+
+        writeFile(path, "vsync=off");
+        watcher.poll();
+
+        auto newConfig = lazyConfig.getLoaded();
+        std::cout << "Version " << lazyConfig.version() << ": "
+                  << newConfig->text() << std::endl;
+        std::cout << "Old pointer still reads: " << oldConfig->text()
+                  << ", is current: " << oldConfig.is_current() << std::endl;
+        std::cout << "New pointer is current: " << newConfig.is_current()
+                  << std::endl;
+        std::cout << "Retired bytes: " << configs.retired_memory()
+                  << ", used bytes: " << configs.used_memory() << std::endl;
+        std::cout << "Dropping both pointers..." << std::endl;
+    }
+
+    configs.cleanAll();
+    std::cout << "Retired bytes after dropping: " << configs.retired_memory()
+              << std::endl;
+    std::filesystem::remove_all(dir);
+
+    return 0;
+}
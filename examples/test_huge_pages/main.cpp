@@ -0,0 +1,105 @@
+// Demonstrates the huge page arena: many small assets are placed one after
+// another in huge page backed memory, which is committed as they fill it and
+// reused after they are unloaded.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/huge_page_arena.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+class Particle : public dynasma::PolymorphicBase {
+    float m_position[3];
+    float m_velocity[3];
+
+  public:
+    Particle(int index)
+        : m_position{float(index), 0, 0}, m_velocity{0, 1, 0} {}
+
+    float x() const { return m_position[0]; }
+
+    std::size_t memory_cost() const { return sizeof(Particle); }
+};
+
+struct ParticleSeed {
+    using Asset = Particle;
+    int kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+constexpr int PARTICLE_COUNT = 100000;
+
+void printMemory(const char *when,
+                 const dynasma::HugePageArenaAllocator<Particle> &arena) {
+    std::cout << when << ": reserved " << (arena.reserved_memory() >> 20)
+              << " MB, committed " << (arena.committed_memory() >> 20)
+              << " MB, used " << (arena.used_memory() >> 10) << " KB"
+              << std::endl;
+}
+
+int main() {
+    dynasma::HugePageArenaAllocator<Particle> arena(std::size_t(64) << 20);
+    dynasma::BasicManager<ParticleSeed,
+                          dynasma::HugePageArenaAllocator<Particle>>
+        particles(arena);
+    printMemory("Empty", arena);
+
+    std::vector<dynasma::LazyPtr<Particle>> lazyParticles;
+    for (int i = 0; i < PARTICLE_COUNT; i++) {
+        lazyParticles.push_back(particles.register_asset_k(i));
+    }
+
+    for (int round = 0; round < 2; round++) {
+        std::vector<dynasma::FirmPtr<Particle>> loaded;
+        for (auto &particle : lazyParticles) {
+            loaded.push_back(particle.getLoaded());
+        }
+
+        bool contiguous = true;
+        float sum = 0;
+        for (std::size_t i = 0; i < loaded.size(); i++) {
+            sum += loaded[i]->x();
+            if (i > 0) {
+                auto *p_prev = reinterpret_cast<const std::byte *>(
+                    &*loaded[i - 1]);
+                auto *p_this = reinterpret_cast<const std::byte *>(&*loaded[i]);
+                // freed particles are reused in reverse order
+                contiguous &= std::abs(p_this - p_prev) <= 64;
+            }
+        }
+        std::cout << "Round " << round << ": sum " << sum
+                  << ", placed contiguously: " << contiguous << std::endl;
+        printMemory("Loaded", arena);
+
+        loaded.clear();
+        particles.cleanAll();
+        printMemory("Unloaded", arena);
+    }
+
+    lazyParticles.clear();
+    particles.cleanAll();
+
+    // a rebound copy needing stricter alignment doesn't reuse a freed block
+    // of the same size
+    struct alignas(64) CacheLine {
+        std::byte bytes[64];
+    };
+    dynasma::HugePageArenaAllocator<char> byteArena(arena);
+    char *p_header = byteArena.allocate(16);
+    char *p_bytes = byteArena.allocate(64);
+    byteArena.deallocate(p_bytes, 64);
+    dynasma::HugePageArenaAllocator<CacheLine> lineArena(byteArena);
+    CacheLine *p_line = lineArena.allocate(1);
+    std::cout << "Rebound block aligned to 64: "
+              << (reinterpret_cast<std::uintptr_t>(p_line) % 64 == 0)
+              << std::endl;
+    lineArena.deallocate(p_line, 1);
+    byteArena.deallocate(p_header, 16);
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Demonstrates seed interning: long path seeds are stored once by a
+// SeedInterner, and the cacher is keyed by pointer-sized InternedSeeds that
+// compare without looking at the paths.
+
+#include "dynasma/cachers/basic.hpp"
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/interning.hpp"
+
+#include <iostream>
+#include <string>
+#include <unordered_set>
+
+class Texture : public dynasma::PolymorphicBase {
+    std::string m_path;
+
+  public:
+    Texture(std::string path) : m_path(path) {
+        std::cout << "--- Texture " << path << " loaded" << std::endl;
+    }
+    ~Texture() {
+        std::cout << "--- Texture " << m_path << " unloaded" << std::endl;
+    }
+
+    std::size_t memory_cost() const { return sizeof(Texture); }
+};
+
+struct TextureSeed {
+    using Asset = Texture;
+    std::string kernel;
+
+    std::size_t load_cost() const { return 1; }
+
+    bool operator<(const TextureSeed &other) const {
+        return kernel < other.kernel;
+    }
+};
+
+using Seed = dynasma::InternedSeed<TextureSeed>;
+
+int main() {
+    dynasma::SeedInterner<TextureSeed> paths;
+    dynasma::BasicCacher<Seed, std::allocator<Texture>> cacher;
+
+    std::string prefix = "assets/environment/forest/textures/high_quality/";
+
+    Seed bark = paths.intern_k(prefix + "bark_albedo.png");
+    Seed leaves = paths.intern_k(prefix + "leaves_albedo.png");
+    Seed barkAgain = paths.intern_k(prefix + "bark_albedo.png");
+
+    std::cout << "sizeof(TextureSeed): " << sizeof(TextureSeed)
+              << ", sizeof(InternedSeed): " << sizeof(Seed) << std::endl;
+    std::cout << "Distinct seeds: " << paths.size() << std::endl;
+    std::cout << "Interned twice is identical: " << (bark == barkAgain)
+              << std::endl;
+
+    {
+        auto firmBark = cacher.retrieve_asset(bark).getLoaded();
+        auto firmLeaves = cacher.retrieve_asset(leaves).getLoaded();
+        auto firmBarkAgain = cacher.retrieve_asset(barkAgain).getLoaded();
+
+        std::cout << "Same bark texture: " << (&*firmBark == &*firmBarkAgain)
+                  << std::endl;
+    }
+
+    // interned seeds hash by identity too
+    std::unordered_set<Seed> seen{bark, leaves, barkAgain};
+    std::cout << "Distinct in a hash set: " << seen.size() << std::endl;
+
+    cacher.cleanAll();
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Demonstrates memory statistics of the pools: with many small assets, the
+// pools' own bookkeeping outweighs the assets. With metadata accounting,
+// cleaning compacts the seeds of unloaded sprites and counts the forgotten
+// icons' registry entries as freed.
+
+#include "dynasma/cachers/basic.hpp"
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Sprite : public dynasma::PolymorphicBase {
+    int m_frame;
+
+  public:
+    Sprite(int frame) : m_frame(frame) {}
+
+    int frame() const { return m_frame; }
+
+    std::size_t memory_cost() const { return sizeof(Sprite); }
+};
+
+struct SpriteSeed {
+    using Asset = Sprite;
+    int kernel;
+    // shown in the editor only, rebuilt from the sprite sheet when needed
+    std::string description;
+
+    std::size_t memory_cost() const {
+        return description.capacity() > sizeof(std::string)
+                   ? description.capacity()
+                   : 0;
+    }
+    std::size_t compact() {
+        std::size_t cost = memory_cost();
+        description.clear();
+        description.shrink_to_fit();
+        return cost;
+    }
+    std::size_t load_cost() const { return 1; }
+};
+
+struct IconSeed {
+    using Asset = Sprite;
+    int kernel;
+
+    std::size_t load_cost() const { return 1; }
+    bool operator<(const IconSeed &other) const {
+        return kernel < other.kernel;
+    }
+};
+
+constexpr int SPRITE_COUNT = 1000;
+
+void print(const char *label, dynasma::PoolMemory stats) {
+    std::cout << label << ": assets " << stats.asset_bytes << " B, metadata "
+              << stats.metadata_bytes << " B" << std::endl;
+}
+
+int main() {
+    dynasma::BasicManager<SpriteSeed, std::allocator<Sprite>> sprites;
+
+    std::vector<dynasma::LazyPtr<Sprite>> lazySprites;
+    std::vector<dynasma::FirmPtr<Sprite>> shown;
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        lazySprites.push_back(sprites.register_asset(SpriteSeed{
+            i, "Frame " + std::to_string(i) + " of the walking animation"}));
+        shown.push_back(lazySprites.back().getLoaded());
+    }
+    print("Sprites shown", sprites.memory_stats());
+
+    // without metadata accounting, only the sprites count
+    shown.clear();
+    std::size_t freed = sprites.cleanAll();
+    std::cout << "Unloaded sprites, freed " << freed << " B" << std::endl;
+    print("Sprites unloaded", sprites.memory_stats());
+
+    // the unloaded sprites' seeds are compacted when memory is tight
+    sprites.set_metadata_accounting(true);
+    freed = sprites.cleanAll();
+    std::cout << "Compacted seeds, freed " << freed << " B" << std::endl;
+    print("Sprites compacted", sprites.memory_stats());
+
+    // compacted seeds still construct their sprites
+    bool reloaded = lazySprites[7].getLoaded()->frame() == 7;
+    std::cout << "Reloaded after compaction: " << reloaded << std::endl;
+
+    dynasma::BasicCacher<IconSeed, std::allocator<Sprite>> icons;
+    icons.set_metadata_accounting(true);
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        // loaded, then cached with nothing remembering it
+        icons.retrieve_asset_k(i).getLoaded();
+    }
+    print("Icons cached", icons.memory_stats());
+    freed = icons.cleanAll();
+    std::cout << "Unloaded and forgot icons, freed " << freed << " B"
+              << std::endl;
+    print("Icons forgotten", icons.memory_stats());
+
+    lazySprites.clear();
+    sprites.cleanAll();
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Demonstrates NUMA placement: textures and the materials using them are
+// allocated from slabs on one NUMA node, and each material is placed in the
+// slab of its texture, through the locality hint the manager passes.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+#include "dynasma/util/numa_allocator.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class Texture : public dynasma::PolymorphicBase {
+    std::array<char, 1200> m_pixels;
+
+  public:
+    Texture(std::string name) { m_pixels.fill(name[0]); }
+
+    std::size_t memory_cost() const { return sizeof(Texture); }
+};
+
+struct TextureSeed {
+    using Asset = Texture;
+    std::string kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+class Material : public dynasma::PolymorphicBase {
+    dynasma::FirmPtr<Texture> m_texture;
+
+  public:
+    Material(dynasma::LazyPtr<Texture> texture)
+        : m_texture(texture.getLoaded()) {}
+
+    const Texture *texture() const { return &*m_texture; }
+
+    std::size_t memory_cost() const { return sizeof(Material); }
+};
+
+struct MaterialSeed {
+    using Asset = Material;
+    dynasma::LazyPtr<Texture> kernel;
+
+    std::array<dynasma::LazyPtr<Texture>, 1> dependencies() const {
+        return {kernel};
+    }
+    std::size_t load_cost() const { return 1; }
+};
+
+int main() {
+    int node = dynasma::currentNumaNode();
+    std::cout << "NUMA nodes: " << dynasma::numaNodeCount() << std::endl;
+
+    // small slabs, so the textures are spread over several of them.
+    // The material allocator shares the slabs of the texture one
+    dynasma::NumaAllocator<Texture> textureAlloc(node, false, 4096);
+    dynasma::NumaAllocator<Material> materialAlloc(textureAlloc);
+    dynasma::BasicManager<TextureSeed, dynasma::NumaAllocator<Texture>>
+        textures(textureAlloc);
+    dynasma::BasicManager<MaterialSeed, dynasma::NumaAllocator<Material>>
+        materials(materialAlloc);
+
+    {
+        std::vector<dynasma::FirmPtr<Texture>> loadedTextures;
+        std::vector<dynasma::LazyPtr<Material>> lazyMaterials;
+        for (std::string name : {"brick", "grass", "water", "stone", "wood",
+                                 "sand"}) {
+            auto texture = textures.register_asset_k(name);
+            loadedTextures.push_back(texture.getLoaded());
+            lazyMaterials.push_back(materials.register_asset_k(texture));
+        }
+        std::cout << "Bound to node " << textureAlloc.node() << ": "
+                  << textureAlloc.is_bound() << ", reserved "
+                  << textureAlloc.reserved_memory() << " bytes" << std::endl;
+
+        // the first material's texture is in an older slab, with room left
+        for (std::size_t i : {0, 5}) {
+            dynasma::FirmPtr<Material> material = lazyMaterials[i].getLoaded();
+            std::cout << "Material " << i << " shares its texture's slab: "
+                      << textureAlloc.share_slab(&*material,
+                                                 material->texture())
+                      << std::endl;
+        }
+    }
+
+    materials.cleanAll();
+    textures.cleanAll();
+
+    // a rebound copy needing stricter alignment doesn't reuse a freed block
+    // of the same size
+    struct alignas(64) CacheLine {
+        std::byte bytes[64];
+    };
+    dynasma::NumaAllocator<char> byteAlloc(node);
+    char *p_header = byteAlloc.allocate(16);
+    char *p_bytes = byteAlloc.allocate(64);
+    byteAlloc.deallocate(p_bytes, 64);
+    dynasma::NumaAllocator<CacheLine> lineAlloc(byteAlloc);
+    CacheLine *p_line = lineAlloc.allocate(1);
+    std::cout << "Rebound block aligned to 64: "
+              << (reinterpret_cast<std::uintptr_t>(p_line) % 64 == 0)
+              << std::endl;
+    lineAlloc.deallocate(p_line, 1);
+    byteAlloc.deallocate(p_header, 16);
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Demonstrates ParallelLoader: a level depends on materials, which depend on
+// textures. The loader finds the whole graph from the level and loads the
+// independent assets in parallel, textures before the materials using them.
+// Built with DYNASMA_CONCURRENT_COUNTERS defined.
+
+#include "dynasma/cachers/concurrent.hpp"
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/parallel_loader.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+std::atomic<int> loadCount{0};
+
+class Texture : public dynasma::PolymorphicBase {
+    std::string m_name;
+
+  public:
+    Texture(std::string name) : m_name(name) {
+        // pretend to decode an image
+        std::this_thread::sleep_for(4ms);
+        loadCount++;
+    }
+
+    const std::string &name() const { return m_name; }
+
+    std::size_t memory_cost() const { return sizeof(Texture); }
+};
+
+struct TextureSeed {
+    using Asset = Texture;
+    std::string kernel;
+
+    std::size_t load_cost() const { return 1; }
+
+    bool operator==(const TextureSeed &other) const = default;
+    bool operator<(const TextureSeed &other) const {
+        return kernel < other.kernel;
+    }
+};
+
+template <> struct std::hash<TextureSeed> {
+    std::size_t operator()(const TextureSeed &seed) const {
+        return std::hash<std::string>{}(seed.kernel);
+    }
+};
+
+struct MaterialDesc {
+    std::string name;
+    std::vector<dynasma::LazyPtr<Texture>> textures;
+
+    bool operator==(const MaterialDesc &other) const = default;
+};
+
+class Material : public dynasma::PolymorphicBase {
+    std::vector<dynasma::FirmPtr<Texture>> m_textures;
+
+  public:
+    Material(const MaterialDesc &desc) {
+        // the loader loaded our textures first, so this doesn't block
+        for (auto &texture : desc.textures) {
+            m_textures.push_back(texture.getLoaded());
+        }
+        // pretend to compile a shader
+        std::this_thread::sleep_for(4ms);
+        loadCount++;
+    }
+
+    std::size_t texture_count() const { return m_textures.size(); }
+
+    std::size_t memory_cost() const { return sizeof(Material); }
+};
+
+struct MaterialSeed {
+    using Asset = Material;
+    MaterialDesc kernel;
+
+    const std::vector<dynasma::LazyPtr<Texture>> &dependencies() const {
+        return kernel.textures;
+    }
+    std::size_t load_cost() const { return 1; }
+
+    bool operator==(const MaterialSeed &other) const = default;
+    bool operator<(const MaterialSeed &other) const {
+        return kernel.name < other.kernel.name;
+    }
+};
+
+template <> struct std::hash<MaterialSeed> {
+    std::size_t operator()(const MaterialSeed &seed) const {
+        return std::hash<std::string>{}(seed.kernel.name);
+    }
+};
+
+struct LevelDesc {
+    std::string name;
+    std::vector<dynasma::LazyPtr<Material>> materials;
+
+    bool operator==(const LevelDesc &other) const = default;
+};
+
+class Level : public dynasma::PolymorphicBase {
+    std::vector<dynasma::FirmPtr<Material>> m_materials;
+
+  public:
+    Level(const LevelDesc &desc) {
+        for (auto &material : desc.materials) {
+            m_materials.push_back(material.getLoaded());
+        }
+        loadCount++;
+    }
+
+    std::size_t material_count() const { return m_materials.size(); }
+
+    std::size_t memory_cost() const { return sizeof(Level); }
+};
+
+struct LevelSeed {
+    using Asset = Level;
+    LevelDesc kernel;
+
+    const std::vector<dynasma::LazyPtr<Material>> &dependencies() const {
+        return kernel.materials;
+    }
+    std::size_t load_cost() const { return 1; }
+
+    bool operator==(const LevelSeed &other) const = default;
+    bool operator<(const LevelSeed &other) const {
+        return kernel.name < other.kernel.name;
+    }
+};
+
+template <> struct std::hash<LevelSeed> {
+    std::size_t operator()(const LevelSeed &seed) const {
+        return std::hash<std::string>{}(seed.kernel.name);
+    }
+};
+
+constexpr int TEXTURE_COUNT = 24;
+constexpr int MATERIAL_COUNT = 16;
+constexpr int TEXTURES_PER_MATERIAL = 4;
+
+template <class Duration> double ms(Duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+int main() {
+    dynasma::ConcurrentCacher<TextureSeed, std::allocator<Texture>> textures;
+    dynasma::ConcurrentCacher<MaterialSeed, std::allocator<Material>>
+        materials;
+    dynasma::ConcurrentCacher<LevelSeed, std::allocator<Level>> levels;
+
+    {
+        // describe the level; nothing is loaded yet
+        LevelDesc levelDesc{"level_1", {}};
+        for (int m = 0; m < MATERIAL_COUNT; m++) {
+            MaterialDesc desc{"material_" + std::to_string(m), {}};
+            for (int t = 0; t < TEXTURES_PER_MATERIAL; t++) {
+                // materials share some of the textures
+                int texture = (m * 3 + t) % TEXTURE_COUNT;
+                desc.textures.push_back(textures.retrieve_asset_k(
+                    "texture_" + std::to_string(texture)));
+            }
+            levelDesc.materials.push_back(materials.retrieve_asset_k(desc));
+        }
+        dynasma::LazyPtr<Level> level = levels.retrieve_asset_k(levelDesc);
+
+        dynasma::ParallelLoader loader(4);
+        loader.add_root(level);
+        dynasma::LoadedGraph loaded = loader.load();
+        const dynasma::LoadReport &report = loaded.report();
+
+        std::cout << "Loaded assets: " << report.asset_count
+                  << " (constructed: " << loadCount << ")" << std::endl;
+        std::cout << "Materials in the level: "
+                  << level.getLoaded()->material_count() << std::endl;
+        std::cout << "Wall time: " << ms(report.wall_time) << " ms"
+                  << std::endl;
+        std::cout << "Total work: " << ms(report.total_work) << " ms"
+                  << std::endl;
+        std::cout << "Critical path: " << ms(report.critical_path) << " ms"
+                  << std::endl;
+    }
+
+    // dependents first, as they keep their dependencies referenced
+    levels.cleanAll();
+    materials.cleanAll();
+    textures.cleanAll();
+    std::cout << "Registered textures after cleaning: " << textures.size()
+              << std::endl;
+
+    return 0;
+}
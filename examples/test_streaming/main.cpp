@@ -0,0 +1,99 @@
+// Demonstrates streaming assets: textures are loaded in mip levels, and
+// cleaning under memory pressure drops the finest unleased levels of all
+// textures before unloading any of them.
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/managers/basic.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+class Texture : public dynasma::PolymorphicBase {
+    std::string m_name;
+    // texels of each resident level, from the coarsest (1x1) up
+    std::vector<std::vector<char>> m_levels;
+
+  public:
+    static constexpr std::size_t LEVEL_COUNT = 6;
+
+    Texture(std::string name) : m_name(name) { load_levels(1); }
+
+    std::size_t level_count() const { return LEVEL_COUNT; }
+    std::size_t loaded_levels() const { return m_levels.size(); }
+    void load_levels(std::size_t count) {
+        while (m_levels.size() < count) {
+            std::size_t side = std::size_t(1) << m_levels.size();
+            m_levels.emplace_back(side * side);
+        }
+    }
+    void drop_levels(std::size_t count) { m_levels.resize(count); }
+
+    std::size_t memory_cost() const {
+        std::size_t cost = sizeof(Texture);
+        for (auto &level : m_levels) {
+            cost += level.size();
+        }
+        return cost;
+    }
+
+    const std::string &name() const { return m_name; }
+};
+
+struct TextureSeed {
+    using Asset = Texture;
+    std::string kernel;
+
+    std::size_t load_cost() const { return 1; }
+};
+
+using Manager = dynasma::BasicManager<TextureSeed, std::allocator<Texture>>;
+
+void printLevels(const std::vector<dynasma::LazyPtr<Texture>> &textures) {
+    for (auto &texture : textures) {
+        if (auto firm = texture.try_get()) {
+            std::cout << " " << (*firm)->name() << ":"
+                      << (*firm)->loaded_levels();
+        } else {
+            std::cout << " " << "unloaded";
+        }
+    }
+    std::cout << std::endl;
+}
+
+int main() {
+    Manager manager;
+
+    std::vector<dynasma::LazyPtr<Texture>> textures;
+    for (std::string name : {"hero", "wall", "floor"}) {
+        textures.push_back(manager.register_asset_k(name));
+    }
+
+    {
+        // the hero is close to the camera and needs full detail
+        Manager::LevelLease hero = manager.lease_levels(textures[0], 6);
+
+        // the others were seen up close before, but aren't needed now
+        manager.lease_levels(textures[1], 6);
+        manager.lease_levels(textures[2], 4);
+        std::cout << "Resident levels:";
+        printLevels(textures);
+
+        std::size_t freed = manager.clean(1000);
+        std::cout << "Cleaned " << freed << " bytes:";
+        printLevels(textures);
+
+        freed = manager.clean(300);
+        std::cout << "Cleaned " << freed << " bytes:";
+        printLevels(textures);
+
+        std::cout << "Hero still has " << hero.asset()->loaded_levels()
+                  << " levels" << std::endl;
+    }
+
+    manager.cleanAll();
+    std::cout << "After cleaning all:";
+    printLevels(textures);
+
+    return 0;
+}
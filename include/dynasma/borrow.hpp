@@ -0,0 +1,132 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_BORROW_H
+#define INCLUDED_DYNASMA_BORROW_H
+
+#include "dynasma/pin.hpp"
+#include "dynasma/pointer.hpp"
+#include "dynasma/util/ref_management.hpp"
+
+#include <cassert>
+#include <functional>
+#include <type_traits>
+
+namespace dynasma {
+
+/**
+ * @brief A borrowed reference to an object kept loaded by a FirmPtr or a
+ * PinPtr. Doesn't touch the reference count, so passing and copying it is
+ * as cheap as passing a raw pointer.
+ * @note Must not outlive the pointer it was borrowed from. Like with
+ * std::string_view, borrowing from a temporary is only safe until the end of
+ * the full expression, i.e. when passing it as an argument.
+ * Debug builds assert that the object is still firmly held when accessed
+ * @example @code
+ *  float area(FirmRef<const Mesh> mesh);
+ *
+ *  for (auto &mesh : meshes) // FirmPtr<Mesh>
+ *      total += area(mesh);  // no hold()/release() per call
+ * @endcode
+ */
+template <class T> class FirmRef {
+    template <class O> friend class FirmRef;
+    friend std::hash<FirmRef>;
+
+    // type-erased reference counter.
+    using RefCtr = PolymorphicReferenceCounter;
+
+    // kept in release builds too, so the layout doesn't depend on NDEBUG
+    RefCtr *m_p_ctr;
+    T *m_p_object;
+
+  public:
+    // Borrowing from pointers that hold the object
+
+    template <class O>
+    FirmRef(const FirmPtr<O> &owner)
+        requires PointerNoCastNeeded<O, T>
+        : m_p_ctr(owner.m_p_ctr), m_p_object(owner.m_p_object) {}
+
+    template <class O>
+    FirmRef(const FirmPtr<O> &owner)
+        requires PointerDynamicCastNeeded<O, T>
+        : m_p_ctr(owner.m_p_ctr),
+          m_p_object(&*dynamic_cast<T *>(owner.m_p_object)) {}
+
+    template <class O>
+    FirmRef(const PinPtr<O> &owner)
+        requires PointerNoCastNeeded<O, T>
+        : m_p_ctr(owner.m_p_ctr), m_p_object(owner.m_p_object) {}
+
+    template <class O>
+    FirmRef(const PinPtr<O> &owner)
+        requires PointerDynamicCastNeeded<O, T>
+        : m_p_ctr(owner.m_p_ctr),
+          m_p_object(&*dynamic_cast<T *>(owner.m_p_object)) {}
+
+    // Copying from other borrows
+
+    FirmRef(const FirmRef &other) = default;
+    FirmRef &operator=(const FirmRef &other) = default;
+
+    template <class O>
+    FirmRef(const FirmRef<O> &other)
+        requires PointerNoCastNeeded<O, T>
+        : m_p_ctr(other.m_p_ctr), m_p_object(other.m_p_object) {}
+
+    template <class O>
+    FirmRef(const FirmRef<O> &other)
+        requires PointerDynamicCastNeeded<O, T>
+        : m_p_ctr(other.m_p_ctr),
+          m_p_object(&*dynamic_cast<T *>(other.m_p_object)) {}
+
+    /**
+     * @brief Takes a firm reference of its own, to keep the object beyond
+     * the borrow
+     */
+    PinPtr<T> pin() const {
+        assert(m_p_ctr->is_usable() && "Borrowed object was released");
+        return PinPtr<T>(*m_p_ctr, m_p_object);
+    }
+
+    // Comparison operators
+
+    template <class O> bool operator==(const FirmRef<O> &other) const {
+        return (void *)m_p_object == (void *)other.m_p_object;
+    }
+    template <class O> auto operator<=>(const FirmRef<O> &other) const {
+        return (void *)m_p_object <=> (void *)other.m_p_object;
+    }
+
+    // Dereferencing
+
+    T &operator*() const {
+        assert(m_p_ctr->is_usable() && "Borrowed object was released");
+        return *m_p_object;
+    }
+    T *operator->() const {
+        assert(m_p_ctr->is_usable() && "Borrowed object was released");
+        return m_p_object;
+    }
+};
+
+/**
+ * @brief Borrows the object without touching the reference count
+ */
+template <class T> FirmRef<T> borrow(const FirmPtr<T> &owner) {
+    return FirmRef<T>(owner);
+}
+template <class T> FirmRef<T> borrow(const PinPtr<T> &owner) {
+    return FirmRef<T>(owner);
+}
+
+} // namespace dynasma
+
+namespace std {
+template <class T> struct hash<dynasma::FirmRef<T>> {
+    size_t operator()(const dynasma::FirmRef<T> &x) const {
+        return (size_t)x.m_p_object;
+    }
+};
+} // namespace std
+
+#endif // INCLUDED_DYNASMA_BORROW_H
@@ -3,6 +3,7 @@
 #define INCLUDED_DYNASMA_CACHER_ABSTRACT_H
 
 #include "dynasma/core_concepts.hpp"
+#include "dynasma/fallback.hpp"
 #include "dynasma/pointer.hpp"
 #include "dynasma/pool.hpp"
 #include "dynasma/util/helpful_concepts.hpp"
@@ -13,7 +14,9 @@ namespace dynasma {
  * @brief Abstract base class for cachers - asset managers that cache and reuse
  * objects with the same seeds
  */
-template <CacheableSeedLike Seed> class AbstractCacher : public AbstractPool {
+template <CacheableSeedLike Seed> class AbstractCacher
+    : public AbstractPool,
+      public FallbackSource<typename Seed::Asset> {
   public:
     using Asset = typename Seed::Asset;
 
@@ -3,28 +3,37 @@
 #define INCLUDED_DYNASMA_CACHER_BASIC_H
 
 #include "dynasma/cachers/abstract.hpp"
+#include "dynasma/cachers/content_table.hpp"
 #include "dynasma/core_concepts.hpp"
 #include "dynasma/pointer.hpp"
+#include "dynasma/pool.hpp"
 #include "dynasma/util/construction.hpp"
+#include "dynasma/util/counter_table.hpp"
+#include "dynasma/util/deferred_destruction.hpp"
 #include "dynasma/util/definitions.hpp"
 #include "dynasma/util/helpful_concepts.hpp"
 #include "dynasma/util/ref_management.hpp"
 
 #include <cassert>
+#include <chrono>
 #include <concepts>
+#include <iterator>
 #include <list>
 #include <map>
-#include <variant>
+#include <vector>
 
 namespace dynasma {
 
 /**
  * @brief A basic asset manager. Allocates assets when they are needed and
- * deletes them when cleanup is requested, oldest first
+ * deletes them when cleanup is requested, oldest first unless another
+ * EvictionPolicy is set
  * @tparam Seed A ReloadableSeedLike type describing everything we need to know
  * about the Asset
  * @tparam Alloc The AllocatorLike type whose instance will be used to construct
  * instances of the Seed::Asset
+ * @note The memory_cost() of each asset is sampled once, right after it is
+ * constructed
  */
 template <CacheableSeedLike Seed, SeededAllocatorLike<Seed> Alloc>
 class BasicCacher : public virtual AbstractCacher<Seed> {
@@ -33,33 +42,77 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
     using ExposedAsset = typename Seed::Asset;
 
   private:
+    class ProxyRefCtr;
+    using Counters = CounterTable<ProxyRefCtr>;
+    using State = typename Counters::State;
+
     // reference counting response implementation
     class ProxyRefCtr : public PolymorphicReferenceCounter {
         BasicCacher &m_manager;
         std::list<ProxyRefCtr>::iterator m_it;
         std::map<Seed, ProxyRefCtr *const>::iterator m_map_it;
+        typename Counters::Slot m_slot;
+
+        // the counter whose equal asset we alias, if any.
+        // We hold it lazily for as long as we remember it, and firmly while
+        // we are used. Aliases are never cached themselves
+        PolymorphicReferenceCounter *m_p_content_owner;
+        std::size_t m_content_hash;
+
+        // whether we are forgettable and wait for the next sweep
+        bool m_marked;
 
       protected:
         void handle_usable_impl() override {
             if (!this->is_loaded()) {
-                const Seed &seed = m_map_it->first;
-
-                // create new
-                ConstructedAsset *p_asset = m_manager.m_allocator.allocate(1);
-                this->p_obj = p_asset;
-
                 // move from unloaded to used
                 this->m_manager.m_used_registry.splice(
                     this->m_manager.m_used_registry.end(),
                     this->m_manager.m_unloaded_registry, m_it);
+                m_manager.m_counters.set_state(m_slot, State::Used);
 
-                // construct (may throw)
-                std::visit(
-                    [p_asset, this](const auto &arg) {
-                        constructObject(p_asset, *this, arg);
-                    },
-                    seed.kernel);
+                if (m_p_content_owner) {
+                    if (m_p_content_owner->is_loaded()) {
+                        // the shared asset is still resident
+                        m_p_content_owner->hold();
+                        this->p_obj = m_p_content_owner->p_get();
+                        return;
+                    }
+                    // it isn't; load our own instance
+                    forget_content_owner();
+                }
+
+                const Seed &seed = m_map_it->first;
+
+                // create new
+                ConstructedAsset *p_asset = allocateNear(
+                    m_manager.m_allocator, localityHint(seed, *this));
+                try {
+                    constructFromKernel(p_asset, *this, seed.kernel);
+                } catch (...) {
+                    // stays unloaded
+                    m_manager.m_allocator.deallocate(p_asset, 1);
+                    this->m_manager.m_unloaded_registry.splice(
+                        this->m_manager.m_unloaded_registry.end(),
+                        this->m_manager.m_used_registry, m_it);
+                    m_manager.m_counters.set_state(m_slot, State::Unloaded);
+                    throw;
+                }
+                this->p_obj = p_asset;
+
+                if constexpr (ContentHashedAsset<ExposedAsset>) {
+                    if (m_manager.m_p_content_table) {
+                        share_content(*p_asset);
+                        if (m_p_content_owner) {
+                            // charged to the owner
+                            return;
+                        }
+                    }
+                }
+                m_manager.m_counters.set_cost(m_slot, p_asset->memory_cost());
             } else {
+                m_manager.m_counters.set_state(m_slot, State::Used);
+
                 // move from cached to used
                 this->m_manager.m_used_registry.splice(
                     this->m_manager.m_used_registry.end(),
@@ -67,28 +120,142 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
             }
         }
         void handle_unloadable_impl() override {
+            if (m_p_content_owner) {
+                // drop the shared asset, the owner caches it for us
+                m_p_content_owner->release();
+                this->p_obj = nullptr;
+                m_manager.m_counters.set_state(m_slot, State::Unloaded);
+
+                // move from used to unloaded
+                this->m_manager.m_unloaded_registry.splice(
+                    this->m_manager.m_unloaded_registry.end(),
+                    this->m_manager.m_used_registry, m_it);
+                return;
+            }
+
             // move from used to cached
+            m_manager.m_counters.set_state(m_slot, State::Cached);
+            m_manager.m_counters.touch(m_slot);
             this->m_manager.m_cached_registry.splice(
                 this->m_manager.m_cached_registry.end(),
                 this->m_manager.m_used_registry, m_it);
         }
         void handle_forgettable_impl() override {
             if (!this->is_loaded()) {
-                forget();
+                forget_or_mark();
             }
             // else we keep it cached for when we remember it
         }
 
         /**
-         * @note This must only be called when the asset is not loaded
+         * Replaces the freshly constructed asset with an equal resident one,
+         * or registers it as the owner of its contents
+         */
+        void share_content(ConstructedAsset &asset)
+            requires ContentHashedAsset<ExposedAsset>
+        {
+            const ExposedAsset &exposed = asset;
+            m_content_hash = exposed.content_hash();
+
+            auto &table = *m_manager.m_p_content_table;
+            PolymorphicReferenceCounter *p_owner =
+                table.find(exposed, m_content_hash);
+
+            if (p_owner) {
+                // alias the resident asset
+                p_owner->lazy_hold();
+                p_owner->hold();
+                destroyObject(&asset);
+                m_manager.m_allocator.deallocate(&asset, 1);
+                this->p_obj = p_owner->p_get();
+                m_p_content_owner = p_owner;
+            } else {
+                table.insert(m_content_hash, *this);
+            }
+        }
+
+        void forget_content_owner() {
+            PolymorphicReferenceCounter *p_owner = m_p_content_owner;
+            m_p_content_owner = nullptr;
+            p_owner->lazy_release();
+        }
+
+        /**
+         * Forgets this now, or marks it for the next sweep if forgetting is
+         * deferred
          */
-        void forget() {
-            m_manager.m_searchable_registry.erase(m_map_it); // removes the seed
-            m_manager.m_unloaded_registry.erase(m_it);       // deletes this
+        void forget_or_mark() {
+            if (!m_manager.m_deferred_forgetting) {
+                forget();
+            } else if (!m_marked) {
+                m_marked = true;
+                m_manager.m_marked_count++;
+            }
         }
 
       public:
-        ProxyRefCtr(BasicCacher &manager) : m_it(), m_manager(manager) {}
+        ProxyRefCtr(BasicCacher &manager)
+            : m_it(), m_manager(manager), m_slot(manager.m_counters.add(*this)),
+              m_p_content_owner(nullptr), m_content_hash(0), m_marked(false) {}
+
+        typename Counters::Slot slot() const { return m_slot; }
+
+        bool is_marked() const { return m_marked; }
+        /**
+         * Keeps this registered, as a LazyPtr remembers it again
+         */
+        void unmark() {
+            if (m_marked) {
+                m_marked = false;
+                m_manager.m_marked_count--;
+            }
+        }
+
+        /**
+         * @returns the counter whose asset we alias, which we stop
+         * remembering, or nullptr. Its lazy reference is for the caller to
+         * release
+         */
+        PolymorphicReferenceCounter *take_content_owner() {
+            PolymorphicReferenceCounter *p_owner = m_p_content_owner;
+            m_p_content_owner = nullptr;
+            return p_owner;
+        }
+
+        /**
+         * @param in_index whether to erase the seed from the index, which a
+         * sweep rebuilding the index drops at once
+         * @note This must only be called when the asset is not loaded
+         */
+        void forget(bool in_index = true) {
+            if (m_p_content_owner) {
+                forget_content_owner();
+            }
+            if (m_marked) {
+                m_manager.m_marked_count--;
+            }
+            m_manager.m_counters.remove(m_slot);
+            if (in_index) {
+                // removes the seed
+                m_manager.m_searchable_registry.erase(m_map_it);
+            }
+            m_manager.m_unloaded_registry.erase(m_it); // deletes this
+        }
+
+        /**
+         * @returns the estimated bytes of this counter, its registry and map
+         * nodes and the seed
+         */
+        std::size_t metadata_cost() const {
+            return sizeof(ProxyRefCtr) + internal::LIST_NODE_OVERHEAD +
+                   sizeof(*m_map_it) + internal::MAP_NODE_OVERHEAD +
+                   seedMemoryCost(m_map_it->first);
+        }
+
+        void collect_dependencies(
+            std::vector<PolymorphicReferenceCounter *> &out) override {
+            collectSeedDependencies(m_map_it->first, out);
+        }
 
         /**
          * Unloads the asset and moves it from the cached registry to the
@@ -98,11 +265,24 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
          */
         void unload() {
             // unload
+            if constexpr (ContentHashedAsset<ExposedAsset>) {
+                if (m_manager.m_p_content_table) {
+                    m_manager.m_p_content_table->erase(m_content_hash, *this);
+                }
+            }
             ConstructedAsset &asset_casted =
                 *dynamic_cast<ConstructedAsset *>(this->p_obj);
-            destroyObject(this->p_obj);
-            m_manager.m_allocator.deallocate(&asset_casted, 1);
+            if (m_manager.m_p_destruction_queue) {
+                m_manager.m_p_destruction_queue->push(
+                    &destroyAndDeallocate<Alloc>, &m_manager.m_allocator,
+                    &asset_casted);
+            } else {
+                destroyObject(this->p_obj);
+                m_manager.m_allocator.deallocate(&asset_casted, 1);
+            }
             this->p_obj = nullptr;
+            m_manager.m_counters.set_cost(m_slot, 0);
+            m_manager.m_counters.set_state(m_slot, State::Unloaded);
 
             // move from cached to unloaded
             m_manager.m_unloaded_registry.splice(
@@ -110,7 +290,7 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
                 m_manager.m_cached_registry, m_it);
 
             if (this->is_forgettable()) {
-                forget();
+                forget_or_mark();
             }
         }
 
@@ -121,6 +301,10 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
             m_it = it;
             m_map_it = map_it;
         }
+        void setSelfIndexPos(
+            std::map<Seed, ProxyRefCtr *const>::iterator map_it) {
+            m_map_it = map_it;
+        }
     };
 
     [[DYNASMA_NO_UNIQUE_ADDRESS]] Alloc m_allocator;
@@ -131,6 +315,145 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
     std::list<ProxyRefCtr> m_used_registry;
     std::map<Seed, ProxyRefCtr *const> m_searchable_registry;
 
+    // contiguous state and cost of each registered counter
+    Counters m_counters;
+
+    // optional content-addressed sharing
+    ContentTable<ExposedAsset> *m_p_content_table = nullptr;
+
+    // where to hand unloaded assets for destruction, if not destroying inline
+    DestructionQueue *m_p_destruction_queue = nullptr;
+
+    EvictionPolicy m_eviction_policy = EvictionPolicy::Oldest;
+
+    // forgettable entries are only marked, and swept by clean() or compact()
+    bool m_deferred_forgetting = false;
+    std::size_t m_marked_count = 0;
+
+    // the index is rebuilt when at least 1/REBUILD_DIVISOR of it is swept
+    static constexpr std::size_t REBUILD_DIVISOR = 2;
+
+    static bool is_past(std::chrono::steady_clock::time_point deadline) {
+        return deadline != std::chrono::steady_clock::time_point::max() &&
+               std::chrono::steady_clock::now() >= deadline;
+    }
+
+    /**
+     * Unloads the cached asset, which also forgets it if no LazyPtr remembers
+     * it
+     * @returns the freed memory cost, with the forgotten bookkeeping if it is
+     * counted
+     */
+    std::size_t unload_victim(ProxyRefCtr &ctr) {
+        std::size_t bFreed = m_counters.cost(ctr.slot());
+        if (this->m_count_metadata && ctr.is_forgettable() &&
+            !m_deferred_forgetting) {
+            // forgotten right away, otherwise counted by the sweep
+            bFreed += ctr.metadata_cost();
+        }
+        ctr.unload();
+        return bFreed;
+    }
+
+    /**
+     * Forgets the marked entries in one pass over the unloaded registry.
+     * If they make up most of the index, the pass goes over the index
+     * instead, moving the survivors' nodes to a new index and dropping the
+     * old one at once, without rebalancing it after each erase
+     * @returns the estimated bytes of the forgotten bookkeeping
+     */
+    std::size_t sweep() {
+        if (m_marked_count == 0) {
+            return 0;
+        }
+
+        // released after the pass, so that no entry gets marked during it
+        std::vector<PolymorphicReferenceCounter *> contentOwners;
+        std::size_t bFreed = 0;
+        auto forget = [&](ProxyRefCtr &ctr, bool in_index) {
+            bFreed += ctr.metadata_cost();
+            if (auto *p_owner = ctr.take_content_owner()) {
+                contentOwners.push_back(p_owner);
+            }
+            ctr.forget(in_index);
+        };
+
+        if (m_marked_count * REBUILD_DIVISOR >= m_searchable_registry.size()) {
+            std::map<Seed, ProxyRefCtr *const> survivors;
+            for (auto it = m_searchable_registry.begin();
+                 it != m_searchable_registry.end();) {
+                ProxyRefCtr &ctr = *it->second;
+                auto next = std::next(it);
+                if (ctr.is_marked()) {
+                    forget(ctr, false);
+                } else {
+                    // the nodes keep their order, so appending is linear
+                    ctr.setSelfIndexPos(survivors.insert(
+                        survivors.end(), m_searchable_registry.extract(it)));
+                }
+                it = next;
+            }
+            m_searchable_registry.swap(survivors);
+        } else {
+            for (auto it = m_unloaded_registry.begin();
+                 it != m_unloaded_registry.end();) {
+                ProxyRefCtr &ctr = *it++;
+                if (ctr.is_marked()) {
+                    forget(ctr, true);
+                }
+            }
+        }
+
+        for (PolymorphicReferenceCounter *p_owner : contentOwners) {
+            p_owner->lazy_release();
+        }
+        return bFreed;
+    }
+
+    /**
+     * Unloads assets, then sweeps the marked entries and trims the counter
+     * table if the bookkeeping is counted
+     */
+    std::size_t clean_until(std::size_t bytenum,
+                            std::chrono::steady_clock::time_point deadline) {
+        std::size_t bFreed = unload_until(bytenum, deadline);
+        std::size_t bSwept = sweep();
+        if (this->m_count_metadata) {
+            bFreed += bSwept;
+            if (bFreed < bytenum) {
+                bFreed += m_counters.shrink();
+            }
+        }
+        return bFreed;
+    }
+
+    /**
+     * Unloads the unloadable assets in the order of the eviction policy,
+     * until the deadline passes
+     */
+    std::size_t unload_until(std::size_t bytenum,
+                            std::chrono::steady_clock::time_point deadline) {
+        // when all cached assets go, their order doesn't need scoring
+        if (m_eviction_policy == EvictionPolicy::CostAware &&
+            bytenum < m_counters.cached_cost()) {
+            return m_counters.unload_victims(
+                bytenum,
+                [this](ProxyRefCtr &ctr) { return unload_victim(ctr); },
+                [deadline] { return is_past(deadline); });
+        }
+
+        std::size_t bFreed = 0;
+        while (bFreed < bytenum && !m_cached_registry.empty()) {
+            bFreed += unload_victim(m_cached_registry.front());
+
+            if (is_past(deadline)) {
+                break;
+            }
+        }
+
+        return bFreed;
+    }
+
   public:
     BasicCacher(const BasicCacher &) = delete;
     BasicCacher(BasicCacher &&) = delete;
@@ -144,12 +467,26 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
     BasicCacher(Alloc &&a) : m_allocator(std::move(a)) {}
     ~BasicCacher()
     {
+        sweep();
         assert(m_unloaded_registry.size() == 0 && m_cached_registry.size() == 0 &&
                m_used_registry.size() == 0);
     }
 
     using AbstractCacher<Seed>::retrieve_asset;
 
+    /**
+     * @brief Enables sharing of equal assets through the given table. Assets
+     * loaded afterwards alias equal resident assets of any cacher using the
+     * same table
+     * @note Must be set before any asset is loaded
+     */
+    void set_content_table(ContentTable<ExposedAsset> &table)
+        requires ContentHashedAsset<ExposedAsset>
+    {
+        assert(m_used_registry.size() == 0 && m_cached_registry.size() == 0);
+        m_p_content_table = &table;
+    }
+
     LazyPtr<ExposedAsset> retrieve_asset(Seed &&seed) override {
         // check if the seed has already been registered
         auto lb = m_searchable_registry.lower_bound(seed);
@@ -157,6 +494,7 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
         if (lb != m_searchable_registry.end() &&
             !(m_searchable_registry.key_comp()(seed, lb->first))) {
             // key already exists
+            lb->second->unmark();
             return LazyPtr<ExposedAsset>(*(lb->second));
         } else {
             // the key does not exist in the map
@@ -178,20 +516,95 @@ class BasicCacher : public virtual AbstractCacher<Seed> {
             return LazyPtr<ExposedAsset>(newCtr);
         }
     }
-    std::size_t clean(std::size_t bytenum) override
-    {
-        /*
-        Unloads the oldest unloadable assets first
-        */
-        std::size_t bFreed = 0;
-        while (bFreed < bytenum && !m_cached_registry.empty()) {
-            bFreed += dynamic_cast<ConstructedAsset &>(
-                          *m_cached_registry.front().p_get())
-                          .memory_cost();
-            m_cached_registry.front().unload();
+    std::size_t clean(std::size_t bytenum) override {
+        return clean_until(bytenum,
+                           std::chrono::steady_clock::time_point::max());
+    }
+    std::size_t clean_for(std::size_t bytenum,
+                          std::chrono::steady_clock::duration budget) override {
+        return clean_until(bytenum, std::chrono::steady_clock::now() + budget);
+    }
+    using AbstractPool::clean_for;
+
+    /**
+     * @brief Sets the order in which clean() unloads the cached assets
+     * @note The CostAware policy scans all registered assets to select each
+     * batch of victims, and pays off when asset costs vary a lot
+     */
+    void set_eviction_policy(EvictionPolicy policy) {
+        m_eviction_policy = policy;
+    }
+
+    /**
+     * @brief Enables or disables deferred forgetting. In the deferred mode,
+     * entries whose last LazyPtr is dropped while their asset isn't loaded
+     * are only marked, and forgotten together by the next clean() or
+     * compact(), in one pass. Dropping many LazyPtrs at once, i.e. on a scene
+     * change, then doesn't erase each seed from the index separately
+     * @note The sweep isn't split by clean_for()'s time budget
+     */
+    void set_deferred_forgetting(bool enabled) {
+        m_deferred_forgetting = enabled;
+        if (!enabled) {
+            sweep();
         }
+    }
 
-        return bFreed;
+    /**
+     * @brief Forgets the marked entries, and trims the counter table
+     * @returns the estimated number of freed bytes of bookkeeping
+     */
+    std::size_t compact() { return sweep() + m_counters.shrink(); }
+
+    /**
+     * @returns the number of entries waiting for the next sweep
+     */
+    std::size_t marked_count() const { return m_marked_count; }
+
+    /**
+     * @returns the total memory cost of the assets held by FirmPtrs
+     */
+    std::size_t used_memory() const { return m_counters.memory(State::Used); }
+
+    /**
+     * @returns the memory cost of the loaded assets, and the estimated size
+     * of the counters, registries and seeds of all registered assets
+     * @note Walks the registries. Aliases of shared assets count only their
+     * own bookkeeping
+     */
+    PoolMemory memory_stats() override {
+        PoolMemory stats;
+        stats.asset_bytes = m_counters.memory(State::Used) +
+                            m_counters.memory(State::Cached);
+        stats.metadata_bytes = m_counters.memory_footprint();
+        for (auto *p_registry :
+             {&m_used_registry, &m_cached_registry, &m_unloaded_registry}) {
+            for (const ProxyRefCtr &ctr : *p_registry) {
+                stats.metadata_bytes += ctr.metadata_cost();
+            }
+        }
+        return stats;
+    }
+
+    /**
+     * @returns the total memory cost of the loaded, but unused assets
+     */
+    std::size_t cached_memory() const {
+        return m_counters.memory(State::Cached);
+    }
+
+    /**
+     * @returns the number of loaded, but unused assets
+     */
+    std::size_t cached_count() const { return m_counters.count(State::Cached); }
+
+    /**
+     * @brief Hands the destruction of unloaded assets to the queue instead of
+     * running it inside clean()
+     * @note The queue must be drained before this manager is destroyed
+     */
+    void set_destruction_queue(DestructionQueue &queue) {
+        m_p_destruction_queue = &queue;
     }
 };
 
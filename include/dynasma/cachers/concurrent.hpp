@@ -0,0 +1,491 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_CACHER_CONCURRENT_H
+#define INCLUDED_DYNASMA_CACHER_CONCURRENT_H
+
+#include "dynasma/cachers/abstract.hpp"
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/pointer.hpp"
+#include "dynasma/util/construction.hpp"
+#include "dynasma/util/definitions.hpp"
+#include "dynasma/util/epochs.hpp"
+#include "dynasma/util/helpful_concepts.hpp"
+#include "dynasma/util/ref_management.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#ifndef DYNASMA_CONCURRENT_COUNTERS
+#error "ConcurrentCacher requires DYNASMA_CONCURRENT_COUNTERS to be defined"
+#endif
+
+namespace dynasma {
+
+/**
+ * @brief A cacher usable from many threads at once, made for many readers and
+ * rare writers. Retrieving an already registered seed and holding its loaded
+ * asset takes no locks; registering new seeds, loading and cleaning do.
+ * Assets are deleted when cleanup is requested, least recently used first
+ * @tparam Seed A CacheableSeedLike type, also hashable and equality
+ * comparable
+ * @tparam Alloc The AllocatorLike type whose instance will be used to construct
+ * instances of the Seed::Asset
+ * @note Seeds are looked up in a hash table whose readers are protected by
+ * epochs. Memory of forgotten seeds is freed by clean() and reclaim(), after
+ * all concurrent lookups have finished
+ * @note Requires DYNASMA_CONCURRENT_COUNTERS
+ */
+template <CacheableSeedLike Seed, SeededAllocatorLike<Seed> Alloc>
+    requires Hashable<Seed> && std::equality_comparable<Seed>
+class ConcurrentCacher : public virtual AbstractCacher<Seed> {
+  public:
+    using ConstructedAsset = typename Alloc::value_type;
+    using ExposedAsset = typename Seed::Asset;
+
+  private:
+    // reference counting response implementation, and hash table node
+    class ProxyRefCtr : public PolymorphicReferenceCounter {
+        ConcurrentCacher &m_manager;
+        const Seed m_seed;
+        const std::size_t m_hash;
+
+        // written under the manager's lock, read without it
+        std::atomic<ProxyRefCtr *> m_next;
+        std::atomic<bool> m_loaded;
+        std::atomic<std::uint64_t> m_last_use;
+
+        // accessed while the counter is locked or firmly held
+        std::size_t m_cost;
+
+        // position in the manager's counter list
+        std::size_t m_index;
+
+      protected:
+        void handle_usable_impl() override {
+            if (this->is_loaded()) {
+                // cached, no bookkeeping to update
+                touch();
+                return;
+            }
+
+            ConstructedAsset *p_asset;
+            {
+                std::lock_guard lock(m_manager.m_mutex);
+                p_asset = allocateNear(m_manager.m_allocator,
+                                       localityHint(m_seed, *this));
+            }
+            try {
+                // construct outside the lock. Other holders wait for us
+                constructFromKernel(p_asset, *this, m_seed.kernel);
+            } catch (...) {
+                std::lock_guard lock(m_manager.m_mutex);
+                m_manager.m_allocator.deallocate(p_asset, 1);
+                throw;
+            }
+            this->p_obj = p_asset;
+            m_cost = static_cast<ExposedAsset *>(p_asset)->memory_cost();
+            m_manager.m_asset_bytes.fetch_add(m_cost,
+                                              std::memory_order_relaxed);
+            m_loaded.store(true, std::memory_order_relaxed);
+            touch();
+        }
+        void handle_unloadable_impl() override { touch(); }
+        void handle_forgettable_impl() override {
+            std::lock_guard lock(m_manager.m_mutex);
+            forget_if_unused();
+        }
+        void release_last_lazy() override {
+            // clean() may forget us as soon as the count drops to 0, so we
+            // must not be freed before our handler returns
+            auto section = m_manager.m_epochs.read();
+            this->finish_lazy_release();
+        }
+
+      public:
+        ProxyRefCtr(ConcurrentCacher &manager, Seed &&seed, std::size_t hash)
+            : m_manager(manager), m_seed(std::move(seed)), m_hash(hash),
+              m_next(nullptr), m_loaded(false), m_last_use(0), m_cost(0),
+              m_index(0) {}
+
+        const Seed &seed() const { return m_seed; }
+
+        void collect_dependencies(
+            std::vector<PolymorphicReferenceCounter *> &out) override {
+            collectSeedDependencies(m_seed, out);
+        }
+        std::size_t hash() const { return m_hash; }
+        ProxyRefCtr *next() const {
+            return m_next.load(std::memory_order_acquire);
+        }
+        void set_next(ProxyRefCtr *p_next) {
+            m_next.store(p_next, std::memory_order_release);
+        }
+        std::atomic<ProxyRefCtr *> &next_link() { return m_next; }
+        bool loaded() const { return m_loaded.load(std::memory_order_relaxed); }
+        std::uint64_t last_use() const {
+            return m_last_use.load(std::memory_order_relaxed);
+        }
+        void set_index(std::size_t index) { m_index = index; }
+        std::size_t index() const { return m_index; }
+
+        /**
+         * @returns the estimated bytes of this counter, which is also the
+         * index node, and of what its seed owns
+         */
+        std::size_t metadata_cost() const {
+            return sizeof(ProxyRefCtr) + seedMemoryCost(m_seed);
+        }
+
+        void touch() {
+            m_last_use.store(
+                m_manager.m_clock.fetch_add(1, std::memory_order_relaxed),
+                std::memory_order_relaxed);
+        }
+
+        using PolymorphicReferenceCounter::try_lazy_hold;
+
+        /**
+         * Unloads the asset, if it isn't held
+         * @returns the freed memory cost, or 0 if nothing was unloaded
+         * @note Must be called with the manager's lock
+         */
+        std::size_t unload_if_unused() {
+            if (!this->try_lock_unused()) {
+                return 0;
+            }
+            if (!this->is_loaded()) {
+                this->unlock_unused();
+                return 0;
+            }
+            ConstructedAsset *p_asset =
+                dynamic_cast<ConstructedAsset *>(this->p_obj);
+            destroyObject(p_asset);
+            m_manager.m_allocator.deallocate(p_asset, 1);
+            this->p_obj = nullptr;
+            m_loaded.store(false, std::memory_order_relaxed);
+            std::size_t cost = m_cost;
+            m_cost = 0;
+            m_manager.m_asset_bytes.fetch_sub(cost, std::memory_order_relaxed);
+            this->unlock_unused();
+            return cost;
+        }
+
+        /**
+         * Removes the counter from the manager if it isn't referenced nor
+         * loaded. Concurrent lookups fail to revive it from then on
+         * @note Must be called with the manager's lock
+         */
+        void forget_if_unused() {
+            if (!this->try_lock_unused()) {
+                return;
+            }
+            if (this->is_loaded() || !this->try_mark_forgotten()) {
+                // cached for when we remember it, or revived by a lookup
+                this->unlock_unused();
+                return;
+            }
+            // stays locked, so nothing can hold it anymore
+            m_manager.forget(*this);
+        }
+    };
+
+    // a bucket array of the seed index. Nodes are chained through the
+    // counters, newest first
+    struct Table {
+        std::size_t mask;
+        std::unique_ptr<std::atomic<ProxyRefCtr *>[]> buckets;
+
+        Table(std::size_t bucket_count)
+            : mask(bucket_count - 1),
+              buckets(new std::atomic<ProxyRefCtr *>[bucket_count]) {
+            for (std::size_t i = 0; i < bucket_count; i++) {
+                buckets[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        std::atomic<ProxyRefCtr *> &bucket(std::size_t hash) {
+            return buckets[hash & mask];
+        }
+        std::size_t memory_footprint() const {
+            return sizeof(Table) +
+                   (mask + 1) * sizeof(std::atomic<ProxyRefCtr *>);
+        }
+    };
+
+    static constexpr std::size_t INITIAL_BUCKET_COUNT = 64;
+
+    [[DYNASMA_NO_UNIQUE_ADDRESS]] Alloc m_allocator;
+
+    // guards the allocator, the writes to the index and the counter list.
+    // Recursive, since assets may retrieve or drop other assets while being
+    // loaded or unloaded
+    std::recursive_mutex m_mutex;
+
+    std::atomic<Table *> m_p_table;
+    std::vector<ProxyRefCtr *> m_counters;
+
+    // unlinked memory, freed once no lookup can still see it
+    EpochDomain m_epochs;
+    std::vector<ProxyRefCtr *> m_retired_counters;
+    std::vector<Table *> m_retired_tables;
+
+    // logical time of the last use of each asset
+    std::atomic<std::uint64_t> m_clock;
+
+    // total memory cost of the loaded assets
+    std::atomic<std::size_t> m_asset_bytes;
+
+    static ProxyRefCtr *find_in(Table &table, const Seed &seed,
+                                std::size_t hash) {
+        ProxyRefCtr *p_ctr =
+            table.bucket(hash).load(std::memory_order_acquire);
+        while (p_ctr) {
+            if (p_ctr->hash() == hash && p_ctr->seed() == seed) {
+                return p_ctr;
+            }
+            p_ctr = p_ctr->next();
+        }
+        return nullptr;
+    }
+
+    /**
+     * Relinks the nodes into a twice larger table. Lookups running
+     * concurrently may miss, but never see freed memory
+     */
+    void grow() {
+        Table *p_old = m_p_table.load(std::memory_order_relaxed);
+        Table *p_new = new Table((p_old->mask + 1) * 2);
+        for (std::size_t i = 0; i <= p_old->mask; i++) {
+            ProxyRefCtr *p_ctr =
+                p_old->buckets[i].load(std::memory_order_relaxed);
+            while (p_ctr) {
+                ProxyRefCtr *p_next = p_ctr->next();
+                auto &bucket = p_new->bucket(p_ctr->hash());
+                p_ctr->set_next(bucket.load(std::memory_order_relaxed));
+                bucket.store(p_ctr, std::memory_order_release);
+                p_ctr = p_next;
+            }
+        }
+        m_p_table.store(p_new, std::memory_order_release);
+        m_retired_tables.push_back(p_old);
+    }
+
+    /**
+     * Unlinks a forgotten counter and retires it
+     * @note Must be called with the lock
+     */
+    void forget(ProxyRefCtr &ctr) {
+        Table &table = *m_p_table.load(std::memory_order_relaxed);
+        std::atomic<ProxyRefCtr *> *p_link = &table.bucket(ctr.hash());
+        while (p_link->load(std::memory_order_relaxed) != &ctr) {
+            ProxyRefCtr *p_prev = p_link->load(std::memory_order_relaxed);
+            assert(p_prev);
+            p_link = &p_prev->next_link();
+        }
+        p_link->store(ctr.next(), std::memory_order_release);
+
+        m_counters[ctr.index()] = m_counters.back();
+        m_counters[ctr.index()]->set_index(ctr.index());
+        m_counters.pop_back();
+
+        m_retired_counters.push_back(&ctr);
+    }
+
+    /**
+     * @returns a LazyPtr to the counter, if a lazy reference could be taken
+     */
+    static std::optional<LazyPtr<ExposedAsset>>
+    try_reference(ProxyRefCtr &ctr) {
+        if (!ctr.try_lazy_hold()) {
+            return std::nullopt;
+        }
+        LazyPtr<ExposedAsset> ptr(ctr);
+        ctr.lazy_release();
+        return ptr;
+    }
+
+  public:
+    ConcurrentCacher(const ConcurrentCacher &) = delete;
+    ConcurrentCacher(ConcurrentCacher &&) = delete;
+    ConcurrentCacher &operator=(const ConcurrentCacher &) = delete;
+    ConcurrentCacher &operator=(ConcurrentCacher &&) = delete;
+
+    ConcurrentCacher()
+        requires std::default_initializable<Alloc>
+        : m_allocator(), m_p_table(new Table(INITIAL_BUCKET_COUNT)),
+          m_clock(0), m_asset_bytes(0) {}
+    ConcurrentCacher(const Alloc &a)
+        : m_allocator(a), m_p_table(new Table(INITIAL_BUCKET_COUNT)),
+          m_clock(0), m_asset_bytes(0) {}
+    ConcurrentCacher(Alloc &&a)
+        : m_allocator(std::move(a)), m_p_table(new Table(INITIAL_BUCKET_COUNT)),
+          m_clock(0), m_asset_bytes(0) {}
+    ~ConcurrentCacher() {
+        assert(m_counters.size() == 0);
+        reclaim();
+        delete m_p_table.load(std::memory_order_relaxed);
+    }
+
+    using AbstractCacher<Seed>::retrieve_asset;
+
+    LazyPtr<ExposedAsset> retrieve_asset(Seed &&seed) override {
+        std::size_t hash = std::hash<Seed>{}(seed);
+
+        // lock-free hit
+        {
+            auto section = m_epochs.read();
+            ProxyRefCtr *p_ctr = find_in(
+                *m_p_table.load(std::memory_order_acquire), seed, hash);
+            if (p_ctr) {
+                if (auto ptr = try_reference(*p_ctr)) {
+                    return *ptr;
+                }
+            }
+        }
+
+        // miss, or the lookup raced a writer
+        std::lock_guard lock(m_mutex);
+        Table &table = *m_p_table.load(std::memory_order_relaxed);
+        ProxyRefCtr *p_ctr = find_in(table, seed, hash);
+        if (p_ctr) {
+            // registered by another thread meanwhile
+            if (auto ptr = try_reference(*p_ctr)) {
+                return *ptr;
+            }
+        }
+
+        ProxyRefCtr &newCtr = *new ProxyRefCtr(*this, std::move(seed), hash);
+        newCtr.set_index(m_counters.size());
+        m_counters.push_back(&newCtr);
+
+        // publish it
+        auto &bucket = table.bucket(hash);
+        newCtr.set_next(bucket.load(std::memory_order_relaxed));
+        LazyPtr<ExposedAsset> ptr(newCtr);
+        bucket.store(&newCtr, std::memory_order_release);
+
+        if (m_counters.size() > table.mask + 1) {
+            grow();
+        }
+        return ptr;
+    }
+
+    std::size_t clean(std::size_t bytenum) override {
+        std::size_t bFreed = 0;
+        {
+            std::lock_guard lock(m_mutex);
+
+            // least recently used first
+            std::vector<std::pair<std::uint64_t, ProxyRefCtr *>> candidates;
+            for (ProxyRefCtr *p_ctr : m_counters) {
+                if (p_ctr->loaded() && p_ctr->is_unloadable()) {
+                    candidates.emplace_back(p_ctr->last_use(), p_ctr);
+                }
+            }
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const auto &a, const auto &b) {
+                          return a.first < b.first;
+                      });
+
+            for (auto [last_use, p_ctr] : candidates) {
+                if (bFreed >= bytenum) {
+                    break;
+                }
+                // candidates forgotten during this loop are retired, not
+                // freed, and fail to lock
+                bFreed += p_ctr->unload_if_unused();
+                if (p_ctr->is_forgettable()) {
+                    std::size_t retiredCount = m_retired_counters.size();
+                    p_ctr->forget_if_unused();
+                    if (this->m_count_metadata &&
+                        m_retired_counters.size() > retiredCount) {
+                        // freed by reclaim() below
+                        bFreed += p_ctr->metadata_cost();
+                    }
+                }
+            }
+
+            if (this->m_count_metadata && bFreed < bytenum) {
+                std::size_t listBytes =
+                    m_counters.capacity() * sizeof(ProxyRefCtr *);
+                m_counters.shrink_to_fit();
+                bFreed +=
+                    listBytes - m_counters.capacity() * sizeof(ProxyRefCtr *);
+            }
+        }
+        reclaim();
+
+        return bFreed;
+    }
+
+    /**
+     * @brief Frees the memory of forgotten seeds and replaced index tables,
+     * once no concurrent lookup can see it anymore. Called by clean()
+     * @note Waits for the running lookups to finish
+     */
+    void reclaim() {
+        std::vector<ProxyRefCtr *> counters;
+        std::vector<Table *> tables;
+        {
+            std::lock_guard lock(m_mutex);
+            counters.swap(m_retired_counters);
+            tables.swap(m_retired_tables);
+        }
+        if (counters.empty() && tables.empty()) {
+            return;
+        }
+        m_epochs.synchronize();
+        for (ProxyRefCtr *p_ctr : counters) {
+            delete p_ctr;
+        }
+        for (Table *p_table : tables) {
+            delete p_table;
+        }
+    }
+
+    /**
+     * @returns the memory cost of the loaded assets, and the estimated size
+     * of the counters, seeds and index, including the forgotten ones not
+     * reclaimed yet
+     * @note Walks the registered seeds under the lock
+     */
+    PoolMemory memory_stats() override {
+        std::lock_guard lock(m_mutex);
+        PoolMemory stats;
+        stats.asset_bytes = m_asset_bytes.load(std::memory_order_relaxed);
+        stats.metadata_bytes =
+            (m_counters.capacity() + m_retired_counters.capacity()) *
+                sizeof(ProxyRefCtr *) +
+            m_retired_tables.capacity() * sizeof(Table *);
+        for (auto *p_counters : {&m_counters, &m_retired_counters}) {
+            for (ProxyRefCtr *p_ctr : *p_counters) {
+                stats.metadata_bytes += p_ctr->metadata_cost();
+            }
+        }
+        stats.metadata_bytes +=
+            m_p_table.load(std::memory_order_relaxed)->memory_footprint();
+        for (Table *p_table : m_retired_tables) {
+            stats.metadata_bytes += p_table->memory_footprint();
+        }
+        return stats;
+    }
+
+    /**
+     * @returns the number of registered seeds
+     */
+    std::size_t size() {
+        std::lock_guard lock(m_mutex);
+        return m_counters.size();
+    }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_CACHER_CONCURRENT_H
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_CACHER_CONTENT_TABLE_H
+#define INCLUDED_DYNASMA_CACHER_CONTENT_TABLE_H
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/util/ref_management.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <unordered_map>
+
+namespace dynasma {
+
+/**
+ * @brief A content-addressed table of resident assets, shareable between
+ * cachers of the same asset type.
+ * When a cacher with a ContentTable loads an asset equal to an already
+ * resident one, it drops the new instance and aliases the resident one
+ * instead, so the memory is paid (and charged by clean()) only once.
+ * @tparam Asset A ContentHashedAsset type, usually the Seed::Asset
+ * @note The table must outlive all cachers using it
+ */
+template <class Asset> class ContentTable {
+    static_assert(ContentHashedAsset<Asset>,
+                  "ContentTable requires a ContentHashedAsset type");
+
+    using RefCtr = PolymorphicReferenceCounter;
+
+    std::unordered_multimap<std::size_t, RefCtr *> m_entries;
+
+  public:
+    ContentTable() = default;
+    ContentTable(const ContentTable &) = delete;
+    ContentTable &operator=(const ContentTable &) = delete;
+    ~ContentTable() { assert(m_entries.size() == 0); }
+
+    /**
+     * @returns the counter owning a loaded asset equal to `asset`, or nullptr
+     * if there is none
+     */
+    RefCtr *find(const Asset &asset, std::size_t hash) const {
+        auto [begin, end] = m_entries.equal_range(hash);
+        for (auto it = begin; it != end; ++it) {
+            if (dynamic_cast<const Asset &>(*it->second->p_get()) == asset) {
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Registers a loaded asset as the owner of its contents
+     */
+    void insert(std::size_t hash, RefCtr &ctr) {
+        m_entries.emplace(hash, &ctr);
+    }
+
+    /**
+     * @brief Unregisters the owner before its asset gets unloaded
+     */
+    void erase(std::size_t hash, RefCtr &ctr) {
+        auto [begin, end] = m_entries.equal_range(hash);
+        for (auto it = begin; it != end; ++it) {
+            if (it->second == &ctr) {
+                m_entries.erase(it);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @returns the number of distinct resident assets
+     */
+    std::size_t size() const { return m_entries.size(); }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_CACHER_CONTENT_TABLE_H
@@ -0,0 +1,114 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_CLEANER_H
+#define INCLUDED_DYNASMA_CLEANER_H
+
+#include "dynasma/pool.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <vector>
+
+namespace dynasma {
+
+/**
+ * @brief A resumable cleanup over several pools, performed in time-bounded
+ * slices to avoid long pauses.
+ * Cycles through the pools like the cleanup loop in the README, until the
+ * requested number of bytes is freed or a full pass over the pools frees
+ * nothing.
+ * @example @code
+ *  IncrementalCleaner cleaner{&meshManager, &textureCacher};
+ *  cleaner.request(512 * 1024 * 1024);
+ *
+ *  // each frame
+ *  cleaner.step(std::chrono::milliseconds(1));
+ * @endcode
+ */
+class IncrementalCleaner {
+    std::vector<AbstractPool *> m_pools;
+    std::size_t m_remaining;
+    std::size_t m_pool_index;
+    // whether anything was freed since we last started from the first pool
+    bool m_freed_in_pass;
+    // whether the last full pass freed nothing
+    bool m_exhausted;
+
+  public:
+    IncrementalCleaner(std::initializer_list<AbstractPool *> pools = {})
+        : m_pools(pools), m_remaining(0), m_pool_index(0),
+          m_freed_in_pass(false), m_exhausted(false) {}
+
+    void add_pool(AbstractPool &pool) { m_pools.push_back(&pool); }
+
+    /**
+     * @brief Requests an additional number of bytes to free
+     */
+    void request(std::size_t bytenum) {
+        if (bytenum > std::numeric_limits<std::size_t>::max() - m_remaining) {
+            m_remaining = std::numeric_limits<std::size_t>::max();
+        } else {
+            m_remaining += bytenum;
+        }
+        m_exhausted = false;
+    }
+
+    /**
+     * @brief Requests freeing everything that can be freed
+     */
+    void request_all() { request(std::numeric_limits<std::size_t>::max()); }
+
+    /**
+     * @brief Continues cleaning until the time budget is spent
+     * @returns the number of bytes freed by this step
+     */
+    std::size_t step(std::chrono::steady_clock::duration budget) {
+        auto deadline = std::chrono::steady_clock::now() + budget;
+        std::size_t bFreed = 0;
+
+        while (!done()) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline && bFreed > 0) {
+                break;
+            }
+
+            std::size_t freed =
+                m_pools[m_pool_index]->clean_for(m_remaining, deadline - now);
+            bFreed += freed;
+            m_remaining -= freed < m_remaining ? freed : m_remaining;
+            m_freed_in_pass = m_freed_in_pass || freed > 0;
+
+            // a pool that didn't reach the goal has nothing more to give
+            // right now, unless it ran out of time
+            if (freed == 0 || std::chrono::steady_clock::now() < deadline) {
+                m_pool_index++;
+                if (m_pool_index == m_pools.size()) {
+                    m_pool_index = 0;
+                    m_exhausted = !m_freed_in_pass;
+                    m_freed_in_pass = false;
+                }
+            } else {
+                break;
+            }
+        }
+
+        return bFreed;
+    }
+
+    /**
+     * @returns whether the requested bytes were freed, or nothing more can be
+     */
+    bool done() const {
+        return m_remaining == 0 || m_exhausted || m_pools.empty();
+    }
+
+    /**
+     * @returns the number of requested bytes not freed yet
+     */
+    std::size_t remaining() const { return m_remaining; }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_CLEANER_H
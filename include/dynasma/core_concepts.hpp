@@ -6,6 +6,7 @@
 #include "dynasma/util/helpful_concepts.hpp"
 
 #include <concepts>
+#include <ranges>
 #include <variant>
 
 namespace dynasma {
@@ -43,10 +44,62 @@ concept AssetLike = StandardPolymorphic<T> && requires(const T &a) {
     { a.memory_cost() } -> std::convertible_to<std::size_t>;
 };
 
+/**
+ * An asset that can identify its own contents.
+ * Must have a method content_hash() returning a hash of the asset's contents,
+ * and be equality comparable by those contents.
+ * Cachers with a ContentTable share one instance between equal assets.
+ * @example @code
+ *  struct MyTexture: public PolymorphicBase {
+ *      std::vector<std::byte> pixels;
+ *
+ *      std::size_t content_hash() const;
+ *      bool operator==(const MyTexture &other) const {
+ *          return pixels == other.pixels;
+ *      }
+ *  }
+ * @endcode
+ */
+template <typename T>
+concept ContentHashedAsset = requires(const T &a) {
+    { a.content_hash() } -> std::convertible_to<std::size_t>;
+    { a == a } -> std::convertible_to<bool>;
+};
+
+/**
+ * An asset streamed in levels of detail, from the coarsest up.
+ * Must report the number of its levels and of the resident ones, and be able
+ * to load and drop the levels above the coarsest one while loaded.
+ * Its memory_cost() must include only the resident levels.
+ * Managers that support it keep the leased levels resident and drop the
+ * finest ones when cleaning, before unloading whole assets.
+ * @example @code
+ *  struct MyTexture: public PolymorphicBase {
+ *      std::vector<MipLevel> mips;
+ *
+ *      std::size_t level_count() const;
+ *      std::size_t loaded_levels() const;
+ *      // ensures at least `count` levels are resident
+ *      void load_levels(std::size_t count);
+ *      // keeps only the `count` coarsest levels, at least 1
+ *      void drop_levels(std::size_t count);
+ *
+ *      std::size_t memory_cost() const;
+ *  }
+ * @endcode
+ */
+template <typename T>
+concept StreamingAssetLike = requires(T &a, const T &ca, std::size_t n) {
+    { ca.level_count() } -> std::convertible_to<std::size_t>;
+    { ca.loaded_levels() } -> std::convertible_to<std::size_t>;
+    a.load_levels(n);
+    a.drop_levels(n);
+};
+
 /**
  * An asset seed, used to construct an asset.
  * Must have an Asset typedef.
- * Must have a variant member `kernel`.
+ * Must have a member `kernel`, either a variant or a plain value.
  * The Asset must be constructible from each kernel value.
  * Must have a method load_cost() returning the cost of loading.
  * @details
@@ -61,6 +114,15 @@ concept AssetLike = StandardPolymorphic<T> && requires(const T &a) {
  *      // (i.e. time to load or file size)
  *      std::size_t load_cost() const;
  *  }
+ *
+ *  // Seeds with only one kind of kernel can skip the variant
+ *  struct MyFileSeed {
+ *      using Asset = MyAsset;
+ *
+ *      std::filename kernel;
+ *
+ *      std::size_t load_cost() const;
+ *  }
  * @endcode
  */
 template <class T>
@@ -72,6 +134,62 @@ concept SeedLike = requires(T seed) {
     seed.kernel;
 };
 
+/**
+ * An asset seed declaring the assets its asset uses.
+ * Must have a method dependencies() returning a range of LazyPtrs, to the
+ * assets that the Asset's constructor will load.
+ * Used by ParallelLoader to load independent assets in parallel.
+ * @example @code
+ *  struct MaterialSeed {
+ *      using Asset = Material;
+ *
+ *      MaterialDesc kernel;
+ *
+ *      const std::vector<LazyPtr<Texture>> &dependencies() const {
+ *          return kernel.textures;
+ *      }
+ *      std::size_t load_cost() const;
+ *  }
+ * @endcode
+ */
+template <class T>
+concept DependentSeedLike = SeedLike<T> && requires(const T &seed) {
+    { seed.dependencies() } -> std::ranges::range;
+};
+
+/**
+ * An asset seed owning memory besides its own size, part of which it can
+ * give back while its asset isn't loaded.
+ * Must have a method memory_cost() returning the number of bytes it owns,
+ * and a method compact() freeing what it doesn't need to construct the
+ * asset, returning the number of freed bytes.
+ * Pools count the seeds' memory_cost() in their metadata, and managers with
+ * metadata accounting compact the seeds of unloaded assets when cleaning.
+ * @example @code
+ *  struct MeshSeed {
+ *      using Asset = Mesh;
+ *
+ *      std::filesystem::path kernel;
+ *      // parsed from the file's header, only to show in the editor
+ *      std::vector<std::string> material_names;
+ *
+ *      std::size_t memory_cost() const;
+ *      std::size_t compact() {
+ *          std::size_t cost = memory_cost();
+ *          material_names = {};
+ *          return cost;
+ *      }
+ *      std::size_t load_cost() const;
+ *  }
+ * @endcode
+ */
+template <class T>
+concept CompactableSeedLike =
+    SeedLike<T> && requires(T &seed, const T &cseed) {
+        { cseed.memory_cost() } -> std::convertible_to<std::size_t>;
+        { seed.compact() } -> std::convertible_to<std::size_t>;
+    };
+
 /**
  * An asset seed, used to construct an asset later.
  * Must be copy constructible in addition to being SeedLike.
@@ -91,7 +209,7 @@ concept Sortable = requires(T a, T b) {
 /**
  * An asset seed, used to construct an asset. Allows for sorting.
  * Must have an Asset typedef.
- * Must have a variant member `kernel`.
+ * Must have a member `kernel`, either a variant or a plain value.
  * The Asset must be constructible from each kernel value.
  * Must have a method load_cost() returning the cost of loading.
  * Must be sortable using less_than operator
@@ -117,12 +235,34 @@ concept CacheableSeedLike = ReloadableSeedLike<T> && Sortable<T>;
 
 namespace internal {
 
+template <class T, class Kernel> struct ConstructibleFromKernel_type {
+    static constexpr bool value = ConstructibleFrom<T, Kernel>;
+};
+
+// an option of a variant kernel is passed as is, even if it is a variant
+template <class T, class Option>
+struct ConstructibleFromOption_type : ConstructibleFromKernel_type<T, Option> {
+};
+template <class T, class... Args>
+struct ConstructibleFromOption_type<T, std::variant<Args...>> {
+    static constexpr bool value = ConstructibleFrom<T, std::variant<Args...>>;
+};
+
 template <class T, class... Args> struct ConstructibleFromVariantOptions_type;
 template <class T, class... Args>
 struct ConstructibleFromVariantOptions_type<T, std::variant<Args...>> {
-    static constexpr bool value = (ConstructibleFrom<T, Args> && ...);
+    static constexpr bool value =
+        (ConstructibleFromOption_type<T, Args>::value && ...);
 };
 
+template <class T> struct IsVariant : std::false_type {};
+template <class... Args>
+struct IsVariant<std::variant<Args...>> : std::true_type {};
+
+template <class T, class... Args>
+struct ConstructibleFromKernel_type<T, std::variant<Args...>>
+    : ConstructibleFromVariantOptions_type<T, std::variant<Args...>> {};
+
 } // namespace internal
 
 /**
@@ -134,6 +274,16 @@ template <class T, class VariantT>
 concept ConstructibleFromVariantOptions =
     internal::ConstructibleFromVariantOptions_type<T, VariantT>::value;
 
+/**
+ * Concept checking if an asset type is constructible from a seed kernel:
+ * from each option of a variant kernel, or from a plain kernel itself.
+ * @tparam T the asset type
+ * @tparam Kernel the kernel type
+ */
+template <class T, class Kernel>
+concept ConstructibleFromKernel =
+    internal::ConstructibleFromKernel_type<T, Kernel>::value;
+
 /**
  * @brief Allocator for type derived from Seed::Asset. The allocator's
  * value_type must be constructible from each of the possible kernel values,
@@ -143,8 +293,7 @@ concept ConstructibleFromVariantOptions =
 template <class A, class Seed>
 concept SeededAllocatorLike =
     DerivedAllocatorLike<A, typename Seed::Asset> &&
-    ConstructibleFromVariantOptions<typename A::value_type,
-                                    decltype(Seed::kernel)>;
+    ConstructibleFromKernel<typename A::value_type, decltype(Seed::kernel)>;
 
 /**
  * @brief A seed can be constructed by assigning only its kernel to a value
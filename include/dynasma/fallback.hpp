@@ -0,0 +1,112 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_FALLBACK_H
+#define INCLUDED_DYNASMA_FALLBACK_H
+
+#include "dynasma/pointer.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <optional>
+
+namespace dynasma {
+
+/**
+ * @brief A pointer to an asset that points to a fallback object until the
+ * asset is loaded, switching to the asset once it is. Never loads the asset
+ * itself, loading is left to whatever loads it, like a ParallelLoader on
+ * another thread or a FirmPtr taken elsewhere.
+ * Once switched, it holds the asset firmly like a FirmPtr.
+ * @note version() changes on each switch, so callers can detect it
+ * @example @code
+ *  FallbackPtr<Texture> albedo = textures.with_fallback(lazyAlbedo);
+ *  ...
+ *  bind(*albedo); // the fallback texture until lazyAlbedo is loaded
+ * @endcode
+ */
+template <class T> class FallbackPtr {
+    LazyPtr<T> m_target;
+    FirmPtr<T> m_fallback;
+    // the target, once it was found loaded
+    mutable std::optional<FirmPtr<T>> m_resolved;
+    mutable std::size_t m_version;
+
+    // Switches to the target if it got loaded since the last access
+    void poll() const {
+        if (!m_resolved) {
+            m_resolved = m_target.try_get();
+            if (m_resolved) {
+                m_version++;
+            }
+        }
+    }
+
+  public:
+    FallbackPtr(const LazyPtr<T> &target, const FirmPtr<T> &fallback)
+        : m_target(target), m_fallback(fallback), m_version(0) {}
+
+    /**
+     * @returns whether the target is used instead of the fallback
+     */
+    bool is_ready() const {
+        poll();
+        return m_resolved.has_value();
+    }
+
+    /**
+     * @returns a number that changes when the pointed object changes
+     */
+    std::size_t version() const {
+        poll();
+        return m_version;
+    }
+
+    /**
+     * @returns a FirmPtr to the currently pointed object
+     */
+    const FirmPtr<T> &current() const {
+        poll();
+        return m_resolved ? *m_resolved : m_fallback;
+    }
+
+    const LazyPtr<T> &target() const { return m_target; }
+
+    // Dereferencing
+
+    T &operator*() const { return *current(); }
+    T *operator->() const { return &*current(); }
+};
+
+/**
+ * @brief Holds the fallback object of a pool's asset type
+ * @note The fallback is best created independently of the pool, with
+ * makeStandalone()
+ */
+template <class Asset> class FallbackSource {
+    std::optional<FirmPtr<Asset>> m_fallback;
+
+  public:
+    /**
+     * @brief Sets the object to stand in for assets of this pool that aren't
+     * loaded yet
+     */
+    void set_fallback(const FirmPtr<Asset> &fallback) { m_fallback = fallback; }
+    void clear_fallback() { m_fallback.reset(); }
+
+    const std::optional<FirmPtr<Asset>> &fallback() const {
+        return m_fallback;
+    }
+
+    /**
+     * @returns a FallbackPtr pointing to the fallback object until the asset
+     * is loaded
+     * @note The fallback must have been set
+     */
+    FallbackPtr<Asset> with_fallback(const LazyPtr<Asset> &asset) const {
+        assert(m_fallback.has_value() && "No fallback was set");
+        return FallbackPtr<Asset>(asset, *m_fallback);
+    }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_FALLBACK_H
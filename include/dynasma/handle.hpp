@@ -0,0 +1,257 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_HANDLE_H
+#define INCLUDED_DYNASMA_HANDLE_H
+
+#include "dynasma/pointer.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace dynasma {
+
+template <class T> class HandleTable;
+
+namespace internal {
+
+/**
+ * @brief 32 bits of a slot index and the slot's generation, shared by both
+ * handle types
+ */
+class HandleBits {
+  public:
+    static constexpr unsigned INDEX_BITS = 24;
+    static constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr std::uint32_t MAX_GENERATION =
+        (std::uint32_t)-1 >> INDEX_BITS;
+    // never given to a slot, so the null handle is never valid
+    static constexpr std::uint32_t NULL_INDEX = INDEX_MASK;
+
+  protected:
+    std::uint32_t m_bits;
+
+    HandleBits(std::uint32_t index, std::uint32_t generation)
+        : m_bits((generation << INDEX_BITS) | index) {}
+
+  public:
+    HandleBits() : m_bits(NULL_INDEX) {}
+
+    std::uint32_t index() const { return m_bits & INDEX_MASK; }
+    std::uint32_t generation() const { return m_bits >> INDEX_BITS; }
+    bool is_null() const { return index() == NULL_INDEX; }
+
+    bool operator==(const HandleBits &other) const = default;
+};
+
+} // namespace internal
+
+/**
+ * @brief A compact lazy reference to an asset, resolved through the
+ * HandleTable that created it. Doesn't ensure the object is loaded.
+ * @note Handles are plain values and don't count references themselves; the
+ * table holds a LazyPtr until the handle is erased from it
+ */
+template <class T> class LazyHandle : public internal::HandleBits {
+    friend class HandleTable<T>;
+    using internal::HandleBits::HandleBits;
+
+  public:
+    LazyHandle() = default;
+
+    bool operator==(const LazyHandle &other) const = default;
+};
+
+/**
+ * @brief A compact firm reference to an asset, resolved through the
+ * HandleTable that created it. The asset stays loaded until the handle is
+ * released from the table
+ */
+template <class T> class FirmHandle : public internal::HandleBits {
+    friend class HandleTable<T>;
+    using internal::HandleBits::HandleBits;
+
+  public:
+    FirmHandle() = default;
+
+    bool operator==(const FirmHandle &other) const = default;
+};
+
+/**
+ * @brief A dense table of asset references, giving out 32-bit handles in
+ * place of LazyPtr and FirmPtr. Handles to erased entries are detected as
+ * stale through the generation stored in each handle.
+ * Can be fed LazyPtrs from any pool.
+ * @note A slot is retired once its generation would wrap around, so stale
+ * handles are never mistaken for new ones
+ * @note Like the pointers, firm handles only stay valid while the lazy handle
+ * isn't erased. A released firm handle is only detected as stale while no
+ * other firm handle holds the same asset
+ * @example @code
+ *  HandleTable<Mesh> meshes;
+ *  LazyHandle<Mesh> h = meshes.insert(manager.register_asset_k("a.obj"));
+ *
+ *  FirmHandle<Mesh> fh = meshes.firm(h); // loads the mesh
+ *  meshes[fh].draw();
+ *  meshes.release(fh);
+ *  meshes.erase(h);
+ * @endcode
+ */
+template <class T> class HandleTable {
+    using HandleBits = internal::HandleBits;
+
+    struct Slot {
+        std::optional<LazyPtr<T>> lazy;
+        std::optional<FirmPtr<T>> firm;
+        std::uint32_t firm_handles;
+        std::uint32_t generation;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<std::uint32_t> m_free;
+    std::size_t m_size;
+
+    const Slot *find(const HandleBits &handle) const {
+        if (handle.index() >= m_slots.size()) {
+            return nullptr;
+        }
+        const Slot &slot = m_slots[handle.index()];
+        if (slot.generation != handle.generation() || !slot.lazy) {
+            return nullptr;
+        }
+        return &slot;
+    }
+    Slot *find(const HandleBits &handle) {
+        return const_cast<Slot *>(std::as_const(*this).find(handle));
+    }
+    // also checks that the slot is firmly held
+    const Slot *find_firm(const FirmHandle<T> &handle) const {
+        const Slot *p_slot = find(handle);
+        return p_slot && p_slot->firm_handles > 0 ? p_slot : nullptr;
+    }
+
+  public:
+    HandleTable() : m_size(0) {}
+    HandleTable(const HandleTable &) = delete;
+    HandleTable &operator=(const HandleTable &) = delete;
+
+    /**
+     * @brief Stores the pointer, giving out a handle for it
+     * @throws std::length_error if no more handles can be indexed
+     */
+    LazyHandle<T> insert(LazyPtr<T> ptr) {
+        std::uint32_t index;
+        if (!m_free.empty()) {
+            index = m_free.back();
+            m_free.pop_back();
+        } else {
+            if (m_slots.size() == HandleBits::NULL_INDEX) {
+                throw std::length_error("HandleTable is full");
+            }
+            index = (std::uint32_t)m_slots.size();
+            m_slots.push_back(Slot{std::nullopt, std::nullopt, 0, 0});
+        }
+
+        Slot &slot = m_slots[index];
+        slot.lazy = std::move(ptr);
+        m_size++;
+        return LazyHandle<T>(index, slot.generation);
+    }
+
+    /**
+     * @brief Drops the stored pointer, making all handles to it stale
+     * @note All firm handles must be released first
+     */
+    void erase(LazyHandle<T> handle) {
+        Slot *p_slot = find(handle);
+        assert(p_slot && p_slot->firm_handles == 0);
+
+        p_slot->lazy.reset();
+        m_size--;
+        if (p_slot->generation < HandleBits::MAX_GENERATION) {
+            p_slot->generation++;
+            m_free.push_back(handle.index());
+        }
+    }
+
+    /**
+     * @brief Ensures the asset is loaded and keeps it loaded until the
+     * returned handle is released
+     */
+    FirmHandle<T> firm(LazyHandle<T> handle) {
+        Slot *p_slot = find(handle);
+        assert(p_slot);
+
+        if (p_slot->firm_handles == 0) {
+            p_slot->firm = p_slot->lazy->getLoaded();
+        }
+        p_slot->firm_handles++;
+        return FirmHandle<T>(handle.index(), handle.generation());
+    }
+
+    /**
+     * @brief Drops the firm reference of the handle
+     * @returns the lazy handle to the same asset
+     */
+    LazyHandle<T> release(FirmHandle<T> handle) {
+        Slot *p_slot = find(handle);
+        assert(p_slot && p_slot->firm_handles > 0);
+
+        p_slot->firm_handles--;
+        if (p_slot->firm_handles == 0) {
+            p_slot->firm.reset();
+        }
+        return LazyHandle<T>(handle.index(), handle.generation());
+    }
+
+    /**
+     * @returns the asset, or nullptr if the handle is stale
+     */
+    T *get(FirmHandle<T> handle) const {
+        const Slot *p_slot = find_firm(handle);
+        return p_slot ? (*p_slot->firm).operator->() : nullptr;
+    }
+
+    /**
+     * @returns the asset
+     * @note The handle must not be stale
+     */
+    T &operator[](FirmHandle<T> handle) const {
+        assert(find_firm(handle));
+        return **m_slots[handle.index()].firm;
+    }
+
+    bool valid(LazyHandle<T> handle) const { return find(handle) != nullptr; }
+    bool valid(FirmHandle<T> handle) const {
+        return find_firm(handle) != nullptr;
+    }
+
+    /**
+     * @returns the pointer behind the handle, or nullopt if the handle is stale
+     */
+    std::optional<LazyPtr<T>> lazy_ptr(LazyHandle<T> handle) const {
+        const Slot *p_slot = find(handle);
+        if (!p_slot) {
+            return std::nullopt;
+        }
+        return p_slot->lazy;
+    }
+    std::optional<FirmPtr<T>> firm_ptr(FirmHandle<T> handle) const {
+        const Slot *p_slot = find_firm(handle);
+        if (!p_slot) {
+            return std::nullopt;
+        }
+        return p_slot->firm;
+    }
+
+    /**
+     * @returns the number of stored pointers
+     */
+    std::size_t size() const { return m_size; }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_HANDLE_H
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_INTERNING_H
+#define INCLUDED_DYNASMA_INTERNING_H
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/util/construction.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <set>
+
+namespace dynasma {
+
+template <CacheableSeedLike Seed> class SeedInterner;
+
+/**
+ * @brief The kernel of an InternedSeed. Refers to the canonical seed, whose
+ * own kernel is used to construct the asset
+ */
+template <CacheableSeedLike Seed> class InternedKernel {
+    friend class SeedInterner<Seed>;
+
+    const Seed *m_p_seed;
+
+    InternedKernel(const Seed &seed) : m_p_seed(&seed) {}
+
+  public:
+    const Seed &seed() const { return *m_p_seed; }
+
+    bool operator==(const InternedKernel &other) const = default;
+    bool operator<(const InternedKernel &other) const {
+        return std::less<const Seed *>{}(m_p_seed, other.m_p_seed);
+    }
+};
+
+/**
+ * @brief A seed canonicalized by a SeedInterner. Usable in place of the
+ * original seed with any pool, while being the size of a pointer.
+ * Equal seeds interned by the same interner are identical, so comparing and
+ * hashing interned seeds never looks at the original seed's contents
+ */
+template <CacheableSeedLike Seed> struct InternedSeed {
+    using Asset = typename Seed::Asset;
+
+    InternedKernel<Seed> kernel;
+
+    const Seed &seed() const { return kernel.seed(); }
+
+    std::size_t load_cost() const { return seed().load_cost(); }
+
+    bool operator==(const InternedSeed &other) const = default;
+    bool operator<(const InternedSeed &other) const {
+        return kernel < other.kernel;
+    }
+};
+
+/**
+ * @brief Stores one canonical copy of each distinct seed, and hands out
+ * InternedSeeds referring to it.
+ * Seeds are compared in full only when interned, so a cacher keyed by
+ * InternedSeeds stores a pointer per asset and compares pointers per lookup.
+ * @note Interned seeds are kept until the interner is destroyed, which must
+ * happen after all pools using its seeds are destroyed
+ * @example @code
+ *  SeedInterner<TextureSeed> paths;
+ *  BasicCacher<InternedSeed<TextureSeed>, std::allocator<Texture>> cacher;
+ *
+ *  auto seed = paths.intern_k("textures/very/long/path/to/albedo.png");
+ *  LazyPtr<Texture> tex = cacher.retrieve_asset(seed);
+ * @endcode
+ */
+template <CacheableSeedLike Seed> class SeedInterner {
+    std::set<Seed> m_seeds;
+
+  public:
+    SeedInterner() = default;
+    SeedInterner(const SeedInterner &) = delete;
+    SeedInterner &operator=(const SeedInterner &) = delete;
+
+    /**
+     * @returns the interned seed equal to the given seed, interning it if it
+     * wasn't already
+     */
+    InternedSeed<Seed> intern(const Seed &seed) {
+        return InternedSeed<Seed>{
+            InternedKernel<Seed>(*m_seeds.insert(seed).first)};
+    }
+    InternedSeed<Seed> intern(Seed &&seed) {
+        return InternedSeed<Seed>{
+            InternedKernel<Seed>(*m_seeds.insert(std::move(seed)).first)};
+    }
+
+    /**
+     * @brief Interns a seed constructed from the given kernel value
+     */
+    template <class ValueT>
+        requires SeedConstructibleFromKernelValue<Seed, ValueT>
+    InternedSeed<Seed> intern_k(ValueT &&value) {
+        return intern(Seed{.kernel = std::forward<ValueT>(value)});
+    }
+
+    /**
+     * @returns the number of distinct interned seeds
+     */
+    std::size_t size() const { return m_seeds.size(); }
+};
+
+namespace internal {
+
+// an interned kernel constructs whatever the original kernel constructs
+template <class T, CacheableSeedLike Seed>
+struct ConstructibleFromKernel_type<T, InternedKernel<Seed>>
+    : ConstructibleFromKernel_type<T, decltype(Seed::kernel)> {};
+
+} // namespace internal
+
+/**
+ * @brief Constructs the object from the original seed's kernel
+ */
+template <class T, class Ctr, CacheableSeedLike Seed>
+void constructFromKernel(T *p, Ctr &ctr, const InternedKernel<Seed> &kernel) {
+    constructFromKernel(p, ctr, kernel.seed().kernel);
+}
+
+} // namespace dynasma
+
+template <dynasma::CacheableSeedLike Seed>
+struct std::hash<dynasma::InternedSeed<Seed>> {
+    std::size_t operator()(const dynasma::InternedSeed<Seed> &seed) const {
+        return std::hash<const Seed *>{}(&seed.seed());
+    }
+};
+
+#endif // INCLUDED_DYNASMA_INTERNING_H
@@ -5,7 +5,9 @@
 #include "dynasma/core_concepts.hpp"
 #include "dynasma/keepers/abstract.hpp"
 #include "dynasma/pointer.hpp"
+#include "dynasma/pool.hpp"
 #include "dynasma/util/construction.hpp"
+#include "dynasma/util/deferred_destruction.hpp"
 #include "dynasma/util/definitions.hpp"
 #include "dynasma/util/dynamic_typing.hpp"
 #include "dynasma/util/helpful_concepts.hpp"
@@ -13,7 +15,6 @@
 
 #include <concepts>
 #include <list>
-#include <variant>
 
 namespace dynasma {
 
@@ -35,22 +36,36 @@ class NaiveKeeper : public virtual AbstractKeeper<Seed> {
     // reference counting response implementation
     class ProxyRefCtr : public PolymorphicReferenceCounter {
         NaiveKeeper &m_manager;
+        std::size_t m_cost;
 
       protected:
         void handle_usable_impl() override {}
         void handle_unloadable_impl() override {}
-        void handle_forgettable_impl() override { delete this; }
+        void handle_forgettable_impl() override {
+            m_manager.m_asset_count--;
+            m_manager.m_asset_bytes -= m_cost;
+            if (m_manager.m_p_destruction_queue) {
+                m_manager.m_p_destruction_queue->push(&destroy, nullptr, this);
+            } else {
+                delete this;
+            }
+        }
+
+        // Matches DestructionQueue::DestroyFn
+        static void destroy(void *, void *p_ctr) {
+            delete static_cast<ProxyRefCtr *>(p_ctr);
+        }
 
       public:
         ProxyRefCtr(const Seed &seed, NaiveKeeper &manager)
-            : m_manager(manager) {
-            ConstructedAsset *p_asset = m_manager.m_allocator.allocate(1);
+            : m_manager(manager), m_cost(0) {
+            ConstructedAsset *p_asset = allocateNear(
+                m_manager.m_allocator, localityHint(seed, *this));
             this->p_obj = p_asset;
-            std::visit(
-                [p_asset, this](const auto &arg) {
-                    constructObject(p_asset, *this, arg);
-                },
-                seed.kernel);
+            constructFromKernel(p_asset, *this, seed.kernel);
+            m_cost = static_cast<ExposedAsset *>(p_asset)->memory_cost();
+            m_manager.m_asset_count++;
+            m_manager.m_asset_bytes += m_cost;
         }
         ~ProxyRefCtr() {
             ConstructedAsset &asset_casted =
@@ -62,6 +77,13 @@ class NaiveKeeper : public virtual AbstractKeeper<Seed> {
 
     [[DYNASMA_NO_UNIQUE_ADDRESS]] Alloc m_allocator;
 
+    // where to hand forgotten counters for destruction, if not deleting inline
+    DestructionQueue *m_p_destruction_queue = nullptr;
+
+    // number and total memory cost of the assets not forgotten yet
+    std::size_t m_asset_count = 0;
+    std::size_t m_asset_bytes = 0;
+
   public:
     NaiveKeeper(const NaiveKeeper &) = delete;
     NaiveKeeper(NaiveKeeper &&) = delete;
@@ -83,6 +105,23 @@ class NaiveKeeper : public virtual AbstractKeeper<Seed> {
         // do nothing; cleans itself automatically
         return 0;
     }
+
+    /**
+     * @returns the memory cost of the assets, and the size of their counters
+     * @note Assets handed to a DestructionQueue aren't counted anymore
+     */
+    PoolMemory memory_stats() override {
+        return PoolMemory{m_asset_bytes, m_asset_count * sizeof(ProxyRefCtr)};
+    }
+
+    /**
+     * @brief Hands the destruction of assets to the queue instead of running
+     * it when their last pointer is dropped
+     * @note The queue must be drained before this keeper is destroyed
+     */
+    void set_destruction_queue(DestructionQueue &queue) {
+        m_p_destruction_queue = &queue;
+    }
 };
 } // namespace dynasma
 
@@ -3,13 +3,16 @@
 #define INCLUDED_DYNASMA_MAN_ABSTRACT_H
 
 #include "dynasma/core_concepts.hpp"
+#include "dynasma/fallback.hpp"
 #include "dynasma/pointer.hpp"
 #include "dynasma/pool.hpp"
 #include "dynasma/util/helpful_concepts.hpp"
 
 namespace dynasma {
 
-template <ReloadableSeedLike Seed> class AbstractManager : public AbstractPool {
+template <ReloadableSeedLike Seed> class AbstractManager
+    : public AbstractPool,
+      public FallbackSource<typename Seed::Asset> {
   public:
     using Asset = typename Seed::Asset;
 
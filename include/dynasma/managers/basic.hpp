@@ -5,25 +5,37 @@
 #include "dynasma/core_concepts.hpp"
 #include "dynasma/managers/abstract.hpp"
 #include "dynasma/pointer.hpp"
+#include "dynasma/pool.hpp"
 #include "dynasma/util/construction.hpp"
+#include "dynasma/util/counter_table.hpp"
+#include "dynasma/util/deferred_destruction.hpp"
+#include "dynasma/util/dense_storage.hpp"
 #include "dynasma/util/definitions.hpp"
 #include "dynasma/util/helpful_concepts.hpp"
 #include "dynasma/util/ref_management.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <concepts>
 #include <list>
-#include <variant>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace dynasma {
 
 /**
  * @brief A basic asset manager. Allocates assets when they are needed and
- * deletes them when cleanup is requested, oldest first
+ * deletes them when cleanup is requested, oldest first unless another
+ * EvictionPolicy is set
  * @tparam Seed A ReloadableSeedLike type describing everything we need to know
  * about the Asset
  * @tparam Alloc The AllocatorLike type whose instance will be used to construct
  * instances of the Seed::Asset
+ * @note The memory_cost() of each asset is sampled once, right after it is
+ * constructed, and for StreamingAssetLike assets after each change of its
+ * levels
  */
 template <ReloadableSeedLike Seed, SeededAllocatorLike<Seed> Alloc>
 class BasicManager : public virtual AbstractManager<Seed> {
@@ -32,29 +44,62 @@ class BasicManager : public virtual AbstractManager<Seed> {
     using ExposedAsset = typename Seed::Asset;
 
   private:
+    class ProxyRefCtr;
+    using Counters = CounterTable<ProxyRefCtr>;
+    using State = typename Counters::State;
+
+    struct NoLeases {};
+    using Leases = std::conditional_t<StreamingAssetLike<ExposedAsset>,
+                                      std::vector<std::size_t>, NoLeases>;
+
     // reference counting response implementation
     class ProxyRefCtr : public PolymorphicReferenceCounter {
         Seed m_seed;
         BasicManager &m_manager;
         std::list<ProxyRefCtr>::iterator m_it;
+        typename Counters::Slot m_slot;
+
+        // position in the frame's release buffer, or NOT_PENDING
+        std::size_t m_frame_index;
+
+        // incremented on each reload
+        std::size_t m_version;
+
+        // number of LevelLeases per number of leased levels, for streaming
+        // assets
+        [[DYNASMA_NO_UNIQUE_ADDRESS]] Leases m_leases;
 
       protected:
         void handle_usable_impl() override {
+            if (m_frame_index != NOT_PENDING) {
+                // released and re-held within the frame, still in used
+                return;
+            }
             if (!this->is_loaded()) {
                 // create new
-                ConstructedAsset *p_asset = m_manager.m_allocator.allocate(1);
+                ConstructedAsset *p_asset = allocateNear(
+                    m_manager.m_allocator, localityHint(this->m_seed, *this));
+                try {
+                    constructFromKernel(p_asset, *this, this->m_seed.kernel);
+                } catch (...) {
+                    // stays unloaded
+                    m_manager.m_allocator.deallocate(p_asset, 1);
+                    throw;
+                }
                 this->p_obj = p_asset;
-                std::visit(
-                    [p_asset, this](const auto &arg) {
-                        constructObject(p_asset, *this, arg);
-                    },
-                    this->m_seed.kernel);
+                m_manager.set_storage_owner(p_asset, this);
+
+                m_manager.m_counters.set_cost(
+                    m_slot, static_cast<ExposedAsset *>(p_asset)->memory_cost());
+                m_manager.m_counters.set_state(m_slot, State::Used);
 
                 // move from unloaded to used
                 this->m_manager.m_used_registry.splice(
                     this->m_manager.m_used_registry.end(),
                     this->m_manager.m_unloaded_registry, m_it);
             } else {
+                m_manager.m_counters.set_state(m_slot, State::Used);
+
                 // move from cached to used
                 this->m_manager.m_used_registry.splice(
                     this->m_manager.m_used_registry.end(),
@@ -62,21 +107,206 @@ class BasicManager : public virtual AbstractManager<Seed> {
             }
         }
         void handle_unloadable_impl() override {
-            // move from used to cached
-            this->m_manager.m_cached_registry.splice(
-                this->m_manager.m_cached_registry.end(),
-                this->m_manager.m_used_registry, m_it);
+            if (!m_manager.m_retired.empty()) {
+                // nothing points to the older versions anymore
+                m_manager.free_retired(this);
+            }
+            if (m_manager.m_frame_epochs) {
+                // decide at the end of the frame
+                if (m_frame_index == NOT_PENDING) {
+                    m_frame_index = m_manager.m_frame_released.size();
+                    m_manager.m_frame_released.push_back(this);
+                }
+                return;
+            }
+            make_cached();
         }
         void handle_forgettable_impl() override {
+            if (m_frame_index != NOT_PENDING) {
+                // remove from the frame's release buffer
+                auto &released = m_manager.m_frame_released;
+                released[m_frame_index] = released.back();
+                released[m_frame_index]->m_frame_index = m_frame_index;
+                released.pop_back();
+                m_frame_index = NOT_PENDING;
+                make_cached();
+            }
             if (this->is_loaded()) {
                 this->unload();
             }
+            m_manager.m_counters.remove(m_slot);
             m_manager.m_unloaded_registry.erase(m_it); // deletes this
         }
 
       public:
+        static constexpr std::size_t NOT_PENDING = (std::size_t)-1;
+
         ProxyRefCtr(Seed &&seed, BasicManager &manager)
-            : m_seed(seed), m_it(), m_manager(manager) {}
+            : m_seed(seed), m_it(), m_manager(manager),
+              m_slot(manager.m_counters.add(*this)),
+              m_frame_index(NOT_PENDING), m_version(0) {}
+
+        typename Counters::Slot slot() const { return m_slot; }
+        const Seed &seed() const { return m_seed; }
+        bool is_from(const BasicManager &manager) const {
+            return &m_manager == &manager;
+        }
+
+        std::size_t version() const override { return m_version; }
+
+        void collect_dependencies(
+            std::vector<PolymorphicReferenceCounter *> &out) override {
+            collectSeedDependencies(m_seed, out);
+        }
+
+        /**
+         * Moves the asset from the used registry to the cached registry
+         */
+        void make_cached() {
+            m_manager.m_counters.set_state(m_slot, State::Cached);
+            m_manager.m_counters.touch(m_slot);
+            this->m_manager.m_cached_registry.splice(
+                this->m_manager.m_cached_registry.end(),
+                this->m_manager.m_used_registry, m_it);
+        }
+
+        /**
+         * Constructs a new asset from the seed and replaces the loaded one.
+         * The old asset is destroyed when no FirmPtr can point to it anymore
+         * @note If the construction throws, the old asset stays
+         */
+        void reload() {
+            if (!this->is_loaded()) {
+                // the next load will be of the new version anyway
+                m_version++;
+                return;
+            }
+
+            // next to the version it replaces
+            ConstructedAsset *p_asset =
+                allocateNear(m_manager.m_allocator, this->p_obj);
+            try {
+                constructFromKernel(p_asset, *this, this->m_seed.kernel);
+            } catch (...) {
+                m_manager.m_allocator.deallocate(p_asset, 1);
+                throw;
+            }
+            ConstructedAsset *p_old =
+                dynamic_cast<ConstructedAsset *>(this->p_obj);
+            this->p_obj = p_asset;
+            m_manager.set_storage_owner(p_asset, this);
+            m_version++;
+            if constexpr (StreamingAssetLike<ExposedAsset>) {
+                // keep the leased levels resident in the new version too
+                std::size_t levels = leased_levels();
+                if (asset().loaded_levels() < levels) {
+                    asset().load_levels(levels);
+                }
+            }
+            m_manager.m_counters.set_cost(m_slot, asset().memory_cost());
+
+            if (this->is_usable()) {
+                // the FirmPtrs taken before still point to the old asset
+                m_manager.set_storage_owner(p_old, nullptr);
+                m_manager.retire(this, p_old);
+            } else {
+                m_manager.destroy_asset(p_old);
+            }
+        }
+
+        ExposedAsset &asset() {
+            return *static_cast<ExposedAsset *>(
+                dynamic_cast<ConstructedAsset *>(this->p_obj));
+        }
+
+        /**
+         * @returns the highest number of levels leased, at least 1
+         */
+        std::size_t leased_levels() const
+            requires StreamingAssetLike<ExposedAsset>
+        {
+            for (std::size_t n = m_leases.size(); n > 1; n--) {
+                if (m_leases[n - 1] > 0) {
+                    return n;
+                }
+            }
+            return 1;
+        }
+
+        /**
+         * Keeps at least the given number of levels resident, loading them
+         * if needed. The asset must be loaded
+         */
+        void add_lease(std::size_t levels)
+            requires StreamingAssetLike<ExposedAsset>
+        {
+            if (m_leases.size() < levels) {
+                m_leases.resize(levels, 0);
+            }
+            m_leases[levels - 1]++;
+            if (asset().loaded_levels() < levels) {
+                asset().load_levels(levels);
+                m_manager.m_counters.set_cost(m_slot, asset().memory_cost());
+            }
+        }
+        void remove_lease(std::size_t levels)
+            requires StreamingAssetLike<ExposedAsset>
+        {
+            m_leases[levels - 1]--;
+        }
+
+        /**
+         * Drops the levels above the given number, unless they are leased
+         * @returns the number of freed bytes
+         */
+        std::size_t drop_levels_to(std::size_t levels)
+            requires StreamingAssetLike<ExposedAsset>
+        {
+            if (!this->is_loaded() || asset().loaded_levels() <= levels ||
+                leased_levels() > levels) {
+                return 0;
+            }
+            std::size_t oldCost = m_manager.m_counters.cost(m_slot);
+            asset().drop_levels(levels);
+            std::size_t newCost = asset().memory_cost();
+            m_manager.m_counters.set_cost(m_slot, newCost);
+            return oldCost > newCost ? oldCost - newCost : 0;
+        }
+
+        /**
+         * @returns the estimated bytes of this counter, its registry node and
+         * what its seed owns
+         */
+        std::size_t metadata_cost() const {
+            std::size_t cost = sizeof(ProxyRefCtr) +
+                               internal::LIST_NODE_OVERHEAD +
+                               seedMemoryCost(m_seed);
+            if constexpr (StreamingAssetLike<ExposedAsset>) {
+                cost += m_leases.capacity() * sizeof(std::size_t);
+            }
+            return cost;
+        }
+
+        /**
+         * Frees what the seed doesn't need to construct the asset
+         * @returns the number of freed bytes
+         */
+        std::size_t compact_seed() { return compactSeed(m_seed); }
+
+        /**
+         * Points to the asset's new place, after the manager moved it
+         */
+        void relocate(ConstructedAsset *p_asset) { this->p_obj = p_asset; }
+
+        /**
+         * Applies the release recorded during the frame, if still unused
+         */
+        void end_frame() {
+            m_frame_index = NOT_PENDING;
+            if (this->is_unloadable()) {
+                make_cached();
+            }
+        }
 
         /**
          * Unloads the asset and moves it from the cached registry to the
@@ -86,11 +316,11 @@ class BasicManager : public virtual AbstractManager<Seed> {
          */
         void unload() {
             // unload
-            ConstructedAsset &asset_casted =
-                *dynamic_cast<ConstructedAsset *>(this->p_obj);
-            destroyObject(this->p_obj);
-            m_manager.m_allocator.deallocate(&asset_casted, 1);
+            m_manager.destroy_asset(
+                dynamic_cast<ConstructedAsset *>(this->p_obj));
             this->p_obj = nullptr;
+            m_manager.m_counters.set_cost(m_slot, 0);
+            m_manager.m_counters.set_state(m_slot, State::Unloaded);
 
             // move from cached to unloaded
             m_manager.m_unloaded_registry.splice(
@@ -111,7 +341,320 @@ class BasicManager : public virtual AbstractManager<Seed> {
     std::list<ProxyRefCtr> m_cached_registry;
     std::list<ProxyRefCtr> m_used_registry;
 
+    // contiguous state and cost of each registered counter
+    Counters m_counters;
+
+    // where to hand unloaded assets for destruction, if not destroying inline
+    DestructionQueue *m_p_destruction_queue = nullptr;
+
+    // counters released during the current frame, in frame epoch mode
+    std::vector<ProxyRefCtr *> m_frame_released;
+    bool m_frame_epochs = false;
+
+    EvictionPolicy m_eviction_policy = EvictionPolicy::Oldest;
+
+    // a replaced asset that FirmPtrs might still point to
+    struct RetiredAsset {
+        ProxyRefCtr *p_ctr;
+        ConstructedAsset *p_asset;
+        std::size_t cost;
+    };
+    std::vector<RetiredAsset> m_retired;
+    // total memory cost of the retired assets
+    std::size_t m_retired_memory = 0;
+
+    void destroy_asset(ConstructedAsset *p_asset) {
+        // queued assets stay in the storage, but aren't the counter's anymore
+        set_storage_owner(p_asset, nullptr);
+        if (m_p_destruction_queue) {
+            m_p_destruction_queue->push(&destroyAndDeallocate<Alloc>,
+                                        &m_allocator, p_asset);
+        } else {
+            destroyObject(p_asset);
+            if (!fill_hole(p_asset)) {
+                m_allocator.deallocate(p_asset, 1);
+            }
+        }
+    }
+
+    void set_storage_owner(ConstructedAsset *p_asset, ProxyRefCtr *p_ctr) {
+        if constexpr (DenseStorageLike<Alloc>) {
+            m_allocator.set_owner(p_asset, p_ctr);
+        }
+    }
+
+    /**
+     * Whether dense storage can move the assets. Only cached assets are
+     * moved, as no FirmPtr points to them
+     */
+    static constexpr bool RELOCATABLE =
+        DenseStorageLike<Alloc> && std::move_constructible<ConstructedAsset>;
+
+    /**
+     * @returns the last stored asset if it can be moved, or nullptr.
+     * Moving the ones before an immovable asset wouldn't shorten the storage
+     */
+    ConstructedAsset *last_movable()
+        requires RELOCATABLE
+    {
+        ConstructedAsset *p = m_allocator.last();
+        if (!p) {
+            return nullptr;
+        }
+        auto *p_ctr = static_cast<ProxyRefCtr *>(m_allocator.owner(p));
+        return p_ctr && p_ctr->is_cached() ? p : nullptr;
+    }
+
+    /**
+     * Moves a cached asset into an allocated, but unconstructed slot
+     */
+    void move_asset(ConstructedAsset *p_from, ConstructedAsset *p_to)
+        requires RELOCATABLE
+    {
+        auto *p_ctr = static_cast<ProxyRefCtr *>(m_allocator.owner(p_from));
+        new (p_to) ConstructedAsset(std::move(*p_from));
+        destroyObject(p_from);
+        m_allocator.set_owner(p_to, p_ctr);
+        p_ctr->relocate(p_to);
+        m_allocator.deallocate(p_from, 1);
+    }
+
+    /**
+     * Moves the last stored asset into the destroyed asset's slot, to keep
+     * dense storage packed
+     * @returns whether the slot was filled
+     */
+    bool fill_hole(ConstructedAsset *p_hole) {
+        if constexpr (RELOCATABLE) {
+            ConstructedAsset *p_last = last_movable();
+            if (!p_last || !m_allocator.before(p_hole, p_last)) {
+                return false;
+            }
+            move_asset(p_last, p_hole);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * Moves cached assets from the end of the storage into its first holes,
+     * until the deadline passes
+     */
+    std::size_t
+    defragment_until(std::size_t max_moves,
+                     std::chrono::steady_clock::time_point deadline)
+        requires RELOCATABLE
+    {
+        std::size_t moves = 0;
+        while (moves < max_moves) {
+            ConstructedAsset *p_last = last_movable();
+            if (!p_last) {
+                break;
+            }
+            // the first free slot
+            ConstructedAsset *p_hole = m_allocator.allocate(1);
+            if (!m_allocator.before(p_hole, p_last)) {
+                m_allocator.deallocate(p_hole, 1);
+                break;
+            }
+            move_asset(p_last, p_hole);
+            moves++;
+            if (is_past(deadline)) {
+                break;
+            }
+        }
+        m_allocator.shrink();
+        return moves;
+    }
+
+    /**
+     * Keeps the replaced asset of the counter until it isn't firmly held
+     */
+    void retire(ProxyRefCtr *p_ctr, ConstructedAsset *p_asset) {
+        std::size_t cost = static_cast<ExposedAsset *>(p_asset)->memory_cost();
+        m_retired.push_back({p_ctr, p_asset, cost});
+        m_retired_memory += cost;
+    }
+
+    /**
+     * Destroys the replaced assets of the counter
+     */
+    void free_retired(ProxyRefCtr *p_ctr) {
+        for (std::size_t i = 0; i < m_retired.size();) {
+            if (m_retired[i].p_ctr == p_ctr) {
+                m_retired_memory -= m_retired[i].cost;
+                destroy_asset(m_retired[i].p_asset);
+                m_retired[i] = m_retired.back();
+                m_retired.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    static bool is_past(std::chrono::steady_clock::time_point deadline) {
+        return deadline != std::chrono::steady_clock::time_point::max() &&
+               std::chrono::steady_clock::now() >= deadline;
+    }
+
+    /**
+     * Drops the finest levels of all cached and used assets, one level at a
+     * time, until the deadline passes
+     */
+    std::size_t drop_levels(std::size_t bytenum,
+                            std::chrono::steady_clock::time_point deadline)
+        requires StreamingAssetLike<ExposedAsset>
+    {
+        std::size_t maxLevels = 0;
+        for (auto *p_registry : {&m_cached_registry, &m_used_registry}) {
+            for (ProxyRefCtr &ctr : *p_registry) {
+                if (ctr.is_loaded()) {
+                    maxLevels = std::max<std::size_t>(
+                        maxLevels, ctr.asset().loaded_levels());
+                }
+            }
+        }
+
+        std::size_t bFreed = 0;
+        for (std::size_t levels = maxLevels; levels > 1; levels--) {
+            // cached assets lose detail first
+            for (auto *p_registry : {&m_cached_registry, &m_used_registry}) {
+                for (ProxyRefCtr &ctr : *p_registry) {
+                    bFreed += ctr.drop_levels_to(levels - 1);
+                    if (bFreed >= bytenum || is_past(deadline)) {
+                        return bFreed;
+                    }
+                }
+            }
+        }
+        return bFreed;
+    }
+
+    /**
+     * @returns the number of bytes taken by the bookkeeping arrays
+     */
+    std::size_t array_bytes() const {
+        return m_counters.memory_footprint() +
+               m_frame_released.capacity() * sizeof(ProxyRefCtr *) +
+               m_retired.capacity() * sizeof(m_retired[0]);
+    }
+
+    /**
+     * Compacts the seeds of the unloaded assets, then trims the bookkeeping
+     * arrays, until the deadline passes
+     */
+    std::size_t
+    compact_metadata(std::size_t bytenum,
+                     std::chrono::steady_clock::time_point deadline) {
+        std::size_t bFreed = 0;
+        for (ProxyRefCtr &ctr : m_unloaded_registry) {
+            if (bFreed >= bytenum) {
+                return bFreed;
+            }
+            // the ones being loaded are held, and need their seeds
+            if (!ctr.is_usable()) {
+                bFreed += ctr.compact_seed();
+                if (is_past(deadline)) {
+                    return bFreed;
+                }
+            }
+        }
+
+        std::size_t arrayBytes = array_bytes();
+        m_counters.shrink();
+        m_frame_released.shrink_to_fit();
+        m_retired.shrink_to_fit();
+        return bFreed + (arrayBytes - array_bytes());
+    }
+
+    /**
+     * Drops levels of streaming assets first, then unloads assets, then
+     * frees the bookkeeping if it is counted
+     */
+    std::size_t clean_until(std::size_t bytenum,
+                            std::chrono::steady_clock::time_point deadline) {
+        std::size_t bFreed = 0;
+        if constexpr (StreamingAssetLike<ExposedAsset>) {
+            bFreed = drop_levels(bytenum, deadline);
+            if (bFreed >= bytenum || is_past(deadline)) {
+                return bFreed;
+            }
+        }
+        bFreed += unload_until(bytenum - bFreed, deadline);
+        if (this->m_count_metadata && bFreed < bytenum && !is_past(deadline)) {
+            bFreed += compact_metadata(bytenum - bFreed, deadline);
+        }
+        return bFreed;
+    }
+
+    /**
+     * Unloads the unloadable assets in the order of the eviction policy,
+     * until the deadline passes
+     */
+    std::size_t unload_until(std::size_t bytenum,
+                             std::chrono::steady_clock::time_point deadline) {
+        // when all cached assets go, their order doesn't need scoring
+        if (m_eviction_policy == EvictionPolicy::CostAware &&
+            bytenum < m_counters.cached_cost()) {
+            return m_counters.unload_victims(
+                bytenum,
+                [this](ProxyRefCtr &ctr) {
+                    std::size_t cost = m_counters.cost(ctr.slot());
+                    ctr.unload();
+                    return cost;
+                },
+                [deadline] { return is_past(deadline); });
+        }
+
+        std::size_t bFreed = 0;
+        while (bFreed < bytenum && !m_cached_registry.empty()) {
+            bFreed += m_counters.cost(m_cached_registry.front().slot());
+            m_cached_registry.front().unload();
+
+            if (is_past(deadline)) {
+                break;
+            }
+        }
+
+        return bFreed;
+    }
+
   public:
+    /**
+     * @brief Keeps a number of levels of a streaming asset resident while it
+     * lives, and the asset loaded
+     * @note Must not outlive the manager
+     */
+    class LevelLease {
+        friend class BasicManager;
+
+        FirmPtr<ExposedAsset> m_asset;
+        ProxyRefCtr *m_p_ctr;
+        std::size_t m_levels;
+
+        LevelLease(FirmPtr<ExposedAsset> &&asset, ProxyRefCtr &ctr,
+                   std::size_t levels)
+            : m_asset(std::move(asset)), m_p_ctr(&ctr), m_levels(levels) {}
+
+      public:
+        LevelLease(const LevelLease &) = delete;
+        LevelLease &operator=(const LevelLease &) = delete;
+        LevelLease(LevelLease &&other)
+            : m_asset(std::move(other.m_asset)), m_p_ctr(other.m_p_ctr),
+              m_levels(other.m_levels) {
+            other.m_p_ctr = nullptr;
+        }
+        ~LevelLease() {
+            if (m_p_ctr) {
+                m_p_ctr->remove_lease(m_levels);
+            }
+        }
+
+        const FirmPtr<ExposedAsset> &asset() const { return m_asset; }
+        std::size_t levels() const { return m_levels; }
+    };
+
     BasicManager(const BasicManager &) = delete;
     BasicManager(BasicManager &&) = delete;
     BasicManager &operator=(const BasicManager &) = delete;
@@ -136,20 +679,218 @@ class BasicManager : public virtual AbstractManager<Seed> {
             &m_unloaded_registry, m_unloaded_registry.begin());
         return LazyPtr<ExposedAsset>(m_unloaded_registry.front());
     }
-    std::size_t clean(std::size_t bytenum) override
+    std::size_t clean(std::size_t bytenum) override {
+        return clean_until(bytenum,
+                           std::chrono::steady_clock::time_point::max());
+    }
+    std::size_t clean_for(std::size_t bytenum,
+                          std::chrono::steady_clock::duration budget) override {
+        return clean_until(bytenum, std::chrono::steady_clock::now() + budget);
+    }
+    using AbstractPool::clean_for;
+
+    /**
+     * @brief Replaces the asset with a newly constructed one, to pick up
+     * changes of its source data. FirmPtrs taken before keep pointing to the
+     * old asset, which is destroyed once the asset is firmly held by none of
+     * them, while new FirmPtrs point to the new one
+     * @param asset a LazyPtr registered by this manager
+     * @note The holds aren't tracked per version, so all replaced versions
+     * stay in memory while any FirmPtr to the asset lives, even one taken
+     * after the reload. They are counted in used_memory() and can't be
+     * cleaned
+     * @note Unloaded assets are only marked as a new version
+     * @throws whatever the asset's constructor throws, keeping the old asset
+     */
+    void reload(const LazyPtr<ExposedAsset> &asset) {
+        ProxyRefCtr *p_ctr =
+            dynamic_cast<ProxyRefCtr *>(&internal::counterOf(asset));
+        assert(p_ctr && p_ctr->is_from(*this) &&
+               "The asset wasn't registered by this manager");
+        p_ctr->reload();
+    }
+
+    /**
+     * @brief Reloads all registered assets whose seeds satisfy the predicate
+     * @returns the number of reloaded assets
+     */
+    template <std::predicate<const Seed &> Pred>
+    std::size_t reload_if(Pred &&pred) {
+        std::size_t count = 0;
+        for (auto *p_registry :
+             {&m_used_registry, &m_cached_registry, &m_unloaded_registry}) {
+            for (ProxyRefCtr &ctr : *p_registry) {
+                if (pred(ctr.seed())) {
+                    ctr.reload();
+                    count++;
+                }
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Loads the asset with at least the given number of its levels,
+     * and keeps them resident while the returned lease lives.
+     * clean() drops the finest unleased levels of all loaded assets, even of
+     * used ones, before it unloads whole assets
+     * @param levels the number of levels, clamped between 1 and the asset's
+     * level_count()
+     * @note Holders should only access the levels they leased, clean() can
+     * drop the others at any time
+     */
+    LevelLease lease_levels(const LazyPtr<ExposedAsset> &asset,
+                            std::size_t levels)
+        requires StreamingAssetLike<ExposedAsset>
     {
-        /*
-        Unloads the oldest unloadable assets first
-        */
-        std::size_t bFreed = 0;
-        while (bFreed < bytenum && !m_cached_registry.empty()) {
-            bFreed +=
-                dynamic_cast<ExposedAsset &>(*m_cached_registry.front().p_get())
-                    .memory_cost();
-            m_cached_registry.front().unload();
+        ProxyRefCtr *p_ctr =
+            dynamic_cast<ProxyRefCtr *>(&internal::counterOf(asset));
+        assert(p_ctr && p_ctr->is_from(*this) &&
+               "The asset wasn't registered by this manager");
+
+        FirmPtr<ExposedAsset> firm = asset.getLoaded();
+        levels = std::clamp<std::size_t>(levels, 1, firm->level_count());
+        p_ctr->add_lease(levels);
+        return LevelLease(std::move(firm), *p_ctr, levels);
+    }
+
+    /**
+     * @brief Hands the destruction of unloaded assets to the queue instead of
+     * running it inside clean()
+     * @note The queue must be drained before this manager is destroyed
+     */
+    void set_destruction_queue(DestructionQueue &queue) {
+        m_p_destruction_queue = &queue;
+    }
+
+    /**
+     * @brief Sets the order in which clean() unloads the cached assets
+     * @note The CostAware policy scans all registered assets to select each
+     * batch of victims, and pays off when asset costs vary a lot
+     */
+    void set_eviction_policy(EvictionPolicy policy) {
+        m_eviction_policy = policy;
+    }
+
+    /**
+     * @returns the total memory cost of the assets held by FirmPtrs,
+     * including the replaced versions they keep alive
+     */
+    std::size_t used_memory() const {
+        return m_counters.memory(State::Used) + m_retired_memory;
+    }
+
+    /**
+     * @returns the total memory cost of the replaced versions that FirmPtrs
+     * keep alive after reloads
+     */
+    std::size_t retired_memory() const { return m_retired_memory; }
+
+    /**
+     * @returns the memory cost of the loaded and retired assets, and the
+     * estimated size of the counters, registries and seeds of all registered
+     * assets
+     * @note Walks the registries
+     */
+    PoolMemory memory_stats() override {
+        PoolMemory stats;
+        stats.asset_bytes = m_counters.memory(State::Used) +
+                            m_counters.memory(State::Cached) +
+                            m_retired_memory;
+        stats.metadata_bytes = array_bytes();
+        for (auto *p_registry :
+             {&m_used_registry, &m_cached_registry, &m_unloaded_registry}) {
+            for (const ProxyRefCtr &ctr : *p_registry) {
+                stats.metadata_bytes += ctr.metadata_cost();
+            }
         }
+        return stats;
+    }
 
-        return bFreed;
+    /**
+     * @brief Moves cached assets from the end of the dense storage into the
+     * holes before them, and frees the emptied chunks. Used assets stay in
+     * place, as FirmPtrs point to them, so it stops at the last used one.
+     * Can be called incrementally, i.e. each frame with a small max_moves
+     * @returns the number of moved assets
+     * @note Only when the allocator is DenseStorageLike and the assets are
+     * move constructible
+     */
+    std::size_t defragment(std::size_t max_moves = (std::size_t)-1)
+        requires RELOCATABLE
+    {
+        return defragment_until(max_moves,
+                                std::chrono::steady_clock::time_point::max());
+    }
+    /**
+     * @brief Like defragment(), but stops once the time budget is spent
+     */
+    std::size_t defragment_for(std::chrono::steady_clock::duration budget)
+        requires RELOCATABLE
+    {
+        return defragment_until((std::size_t)-1,
+                                std::chrono::steady_clock::now() + budget);
+    }
+
+    /**
+     * @brief Calls fn(asset) for each loaded asset, used or cached.
+     * With a DenseStorageLike allocator the assets are visited in storage
+     * order, touching contiguous memory
+     * @note fn must not load or unload assets of this manager
+     */
+    template <class Fn> void for_each_loaded(Fn &&fn) {
+        if constexpr (DenseStorageLike<Alloc>) {
+            m_allocator.for_each([&](ConstructedAsset &asset, void *p_owner) {
+                // replaced versions have no owner
+                if (p_owner) {
+                    fn(static_cast<ExposedAsset &>(asset));
+                }
+            });
+        } else {
+            for (auto *p_registry : {&m_cached_registry, &m_used_registry}) {
+                for (ProxyRefCtr &ctr : *p_registry) {
+                    if (ctr.is_loaded()) {
+                        fn(ctr.asset());
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @returns the total memory cost of the loaded, but unused assets
+     */
+    std::size_t cached_memory() const {
+        return m_counters.memory(State::Cached);
+    }
+
+    /**
+     * @returns the number of loaded, but unused assets
+     */
+    std::size_t cached_count() const { return m_counters.count(State::Cached); }
+
+    /**
+     * @brief Enables or disables frame epochs. In the frame epoch mode,
+     * assets whose last FirmPtr is dropped stay in the used registry until
+     * end_frame(), so assets re-firmed many times per frame get moved between
+     * the registries at most once per frame
+     */
+    void set_frame_epochs(bool enabled) {
+        if (!enabled) {
+            end_frame();
+        }
+        m_frame_epochs = enabled;
+    }
+
+    /**
+     * @brief Moves the assets released during the frame, and not held again,
+     * to the cached registry, making them available for cleaning
+     */
+    void end_frame() {
+        for (ProxyRefCtr *p_ctr : m_frame_released) {
+            p_ctr->end_frame();
+        }
+        m_frame_released.clear();
     }
 };
 
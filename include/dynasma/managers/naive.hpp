@@ -6,22 +6,26 @@
 #include "dynasma/core_concepts.hpp"
 #include "dynasma/managers/abstract.hpp"
 #include "dynasma/pointer.hpp"
+#include "dynasma/pool.hpp"
 #include "dynasma/util/construction.hpp"
+#include "dynasma/util/deferred_destruction.hpp"
 #include "dynasma/util/definitions.hpp"
 #include "dynasma/util/dynamic_typing.hpp"
 #include "dynasma/util/helpful_concepts.hpp"
 #include "dynasma/util/ref_management.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <concepts>
 #include <list>
-#include <variant>
+#include <vector>
 
 namespace dynasma {
 
 /**
  * @brief The naive asset manager. Does the job, but has no advanced memory
- * management or caching features
+ * management or caching features. Can optionally keep assets loaded for a
+ * grace period, see set_grace_period()
  * @tparam Seed A ReloadableSeedLike type describing everything we need to know
  * about the Asset
  * @tparam Alloc The AllocatorLike type whose instance will be used to construct
@@ -40,39 +44,123 @@ class NaiveManager : public virtual AbstractManager<Seed> {
         NaiveManager &m_manager;
         std::list<ProxyRefCtr>::iterator m_it;
 
+        // position in the lingering list, or NOT_LINGERING
+        std::size_t m_linger_index;
+        // the tick at which the lingering asset gets unloaded
+        std::size_t m_unload_tick;
+
       protected:
         void handle_usable_impl() override {
-            ConstructedAsset *p_asset = m_manager.m_allocator.allocate(1);
+            if (this->is_loaded()) {
+                // still lingering, reuse it
+                stop_lingering();
+                return;
+            }
+            ConstructedAsset *p_asset = allocateNear(
+                m_manager.m_allocator, localityHint(m_seed, *this));
+            try {
+                constructFromKernel(p_asset, *this, m_seed.kernel);
+            } catch (...) {
+                m_manager.m_allocator.deallocate(p_asset, 1);
+                throw;
+            }
             this->p_obj = p_asset;
-            std::visit(
-                [p_asset, this](const auto &arg) {
-                    constructObject(p_asset, *this, arg);
-                },
-                m_seed.kernel);
         }
         void handle_unloadable_impl() override {
-            ConstructedAsset &asset_casted =
-                *dynamic_cast<ConstructedAsset *>(this->p_obj);
-            destroyObject(this->p_obj);
-            m_manager.m_allocator.deallocate(&asset_casted, 1);
-            this->p_obj = nullptr;
+            if (m_manager.m_grace_ticks > 0) {
+                m_unload_tick = m_manager.m_tick + m_manager.m_grace_ticks;
+                m_linger_index = m_manager.m_lingering.size();
+                m_manager.m_lingering.push_back(this);
+            } else {
+                unload();
+            }
         }
         void handle_forgettable_impl() override {
+            if (this->is_loaded()) {
+                stop_lingering();
+                unload();
+            }
             m_manager.m_seed_registry.erase(m_it); // deletes this
         }
 
       public:
+        static constexpr std::size_t NOT_LINGERING = (std::size_t)-1;
+
         ProxyRefCtr(Seed &&seed, NaiveManager &manager)
-            : m_seed(seed), m_it(), m_manager(manager) {}
+            : m_seed(seed), m_it(), m_manager(manager),
+              m_linger_index(NOT_LINGERING), m_unload_tick(0) {}
+
+        void collect_dependencies(
+            std::vector<PolymorphicReferenceCounter *> &out) override {
+            collectSeedDependencies(m_seed, out);
+        }
 
         void setSelfRegistryPos(std::list<ProxyRefCtr>::iterator it) {
             m_it = it;
         }
+
+        std::size_t unload_tick() const { return m_unload_tick; }
+
+        /**
+         * Records the position in the lingering list, after it was reordered
+         */
+        void set_linger_index(std::size_t index) { m_linger_index = index; }
+
+        /**
+         * @returns the estimated bytes of this counter, its registry node and
+         * what its seed owns
+         */
+        std::size_t metadata_cost() const {
+            return sizeof(ProxyRefCtr) + internal::LIST_NODE_OVERHEAD +
+                   seedMemoryCost(m_seed);
+        }
+
+        /**
+         * Frees what the seed doesn't need to construct the asset
+         * @returns the number of freed bytes
+         */
+        std::size_t compact_seed() { return compactSeed(m_seed); }
+
+        /**
+         * Removes this from the lingering list, keeping the asset loaded
+         */
+        void stop_lingering() {
+            auto &lingering = m_manager.m_lingering;
+            lingering[m_linger_index] = lingering.back();
+            lingering[m_linger_index]->m_linger_index = m_linger_index;
+            lingering.pop_back();
+            m_linger_index = NOT_LINGERING;
+        }
+
+        /**
+         * Destroys the asset
+         */
+        void unload() {
+            ConstructedAsset &asset_casted =
+                *dynamic_cast<ConstructedAsset *>(this->p_obj);
+            if (m_manager.m_p_destruction_queue) {
+                m_manager.m_p_destruction_queue->push(
+                    &destroyAndDeallocate<Alloc>, &m_manager.m_allocator,
+                    &asset_casted);
+            } else {
+                destroyObject(this->p_obj);
+                m_manager.m_allocator.deallocate(&asset_casted, 1);
+            }
+            this->p_obj = nullptr;
+        }
     };
 
     [[DYNASMA_NO_UNIQUE_ADDRESS]] Alloc m_allocator;
     std::list<ProxyRefCtr> m_seed_registry;
 
+    // where to hand unloaded assets for destruction, if not destroying inline
+    DestructionQueue *m_p_destruction_queue = nullptr;
+
+    // unloadable assets kept loaded until their grace period passes
+    std::vector<ProxyRefCtr *> m_lingering;
+    std::size_t m_grace_ticks = 0;
+    std::size_t m_tick = 0;
+
   public:
     NaiveManager(const NaiveManager &) = delete;
     NaiveManager(NaiveManager &&) = delete;
@@ -84,7 +172,9 @@ class NaiveManager : public virtual AbstractManager<Seed> {
         : m_allocator(){};
     NaiveManager(const Alloc &a) : m_allocator(a) {}
     NaiveManager(Alloc &&a) : m_allocator(std::move(a)) {}
-    ~NaiveManager() { assert(m_seed_registry.size() == 0); }
+    ~NaiveManager() {
+        assert(m_seed_registry.size() == 0 && m_lingering.size() == 0);
+    }
 
     using AbstractManager<Seed>::register_asset;
 
@@ -93,10 +183,104 @@ class NaiveManager : public virtual AbstractManager<Seed> {
         m_seed_registry.front().setSelfRegistryPos(m_seed_registry.begin());
         return LazyPtr<ExposedAsset>(m_seed_registry.front());
     }
-    std::size_t clean(std::size_t bytenum) override
-    {
-        // do nothing; cleans itself automatically
-        return 0;
+    std::size_t clean(std::size_t bytenum) override {
+        // cleans itself automatically, except for the lingering assets
+        std::size_t bFreed = 0;
+        if (bytenum > 0 && m_lingering.size() > 1) {
+            // the ones released longest ago go first, from the back
+            std::sort(m_lingering.begin(), m_lingering.end(),
+                      [](const ProxyRefCtr *a, const ProxyRefCtr *b) {
+                          return a->unload_tick() > b->unload_tick();
+                      });
+            for (std::size_t i = 0; i < m_lingering.size(); i++) {
+                m_lingering[i]->set_linger_index(i);
+            }
+        }
+        while (bFreed < bytenum && !m_lingering.empty()) {
+            ProxyRefCtr &ctr = *m_lingering.back();
+            bFreed +=
+                dynamic_cast<ExposedAsset &>(*ctr.p_get()).memory_cost();
+            ctr.stop_lingering();
+            ctr.unload();
+        }
+
+        if (this->m_count_metadata && bFreed < bytenum) {
+            for (ProxyRefCtr &ctr : m_seed_registry) {
+                if (bFreed >= bytenum) {
+                    return bFreed;
+                }
+                // held ones are loaded or being loaded, and need their seeds
+                if (!ctr.is_loaded() && !ctr.is_usable()) {
+                    bFreed += ctr.compact_seed();
+                }
+            }
+            std::size_t lingeringBytes =
+                m_lingering.capacity() * sizeof(ProxyRefCtr *);
+            m_lingering.shrink_to_fit();
+            bFreed += lingeringBytes -
+                      m_lingering.capacity() * sizeof(ProxyRefCtr *);
+        }
+        return bFreed;
+    }
+
+    /**
+     * @returns the memory cost of the loaded assets, and the estimated size
+     * of the counters, registry and seeds of all registered assets
+     * @note Walks the registry, asking each loaded asset its memory_cost()
+     */
+    PoolMemory memory_stats() override {
+        PoolMemory stats;
+        stats.metadata_bytes = m_lingering.capacity() * sizeof(ProxyRefCtr *);
+        for (ProxyRefCtr &ctr : m_seed_registry) {
+            stats.metadata_bytes += ctr.metadata_cost();
+            if (ctr.is_loaded()) {
+                stats.asset_bytes +=
+                    dynamic_cast<ExposedAsset &>(*ctr.p_get()).memory_cost();
+            }
+        }
+        return stats;
+    }
+
+    /**
+     * @brief Keeps assets loaded for a number of ticks after their last
+     * FirmPtr is dropped, so that assets firmly referenced in short bursts
+     * (i.e. once per frame) don't get reloaded each time
+     * @param ticks the number of tick() calls after which an unused asset is
+     * unloaded. 0 unloads immediately, as by default
+     */
+    void set_grace_period(std::size_t ticks) { m_grace_ticks = ticks; }
+
+    /**
+     * @brief Advances the time and unloads the assets whose grace period
+     * passed
+     * @returns the number of bytes freed (according to memory_cost() functions)
+     */
+    std::size_t tick() {
+        m_tick++;
+
+        std::size_t bFreed = 0;
+        std::size_t i = 0;
+        while (i < m_lingering.size()) {
+            ProxyRefCtr &ctr = *m_lingering[i];
+            if (ctr.unload_tick() <= m_tick) {
+                bFreed +=
+                    dynamic_cast<ExposedAsset &>(*ctr.p_get()).memory_cost();
+                ctr.stop_lingering(); // moves the last one to i
+                ctr.unload();
+            } else {
+                i++;
+            }
+        }
+        return bFreed;
+    }
+
+    /**
+     * @brief Hands the destruction of assets to the queue instead of running
+     * it when their last FirmPtr is dropped
+     * @note The queue must be drained before this manager is destroyed
+     */
+    void set_destruction_queue(DestructionQueue &queue) {
+        m_p_destruction_queue = &queue;
     }
 };
 } // namespace dynasma
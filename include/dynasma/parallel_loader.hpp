@@ -0,0 +1,358 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_PARALLEL_LOADER_H
+#define INCLUDED_DYNASMA_PARALLEL_LOADER_H
+
+#include "dynasma/pointer.hpp"
+#include "dynasma/util/definitions.hpp"
+#include "dynasma/util/ref_management.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef DYNASMA_CONCURRENT_COUNTERS
+#error "ParallelLoader requires DYNASMA_CONCURRENT_COUNTERS to be defined"
+#endif
+
+namespace dynasma {
+
+/**
+ * @brief Timing of a ParallelLoader::load() call
+ */
+struct LoadReport {
+    using Duration = std::chrono::steady_clock::duration;
+
+    // number of distinct assets in the dependency graph
+    std::size_t asset_count = 0;
+    // time from the start of the load to the last constructed asset
+    Duration wall_time = Duration::zero();
+    // summed construction time of all assets
+    Duration total_work = Duration::zero();
+    // the longest chain of construction times through the graph; no number
+    // of threads can load the graph faster
+    Duration critical_path = Duration::zero();
+};
+
+/**
+ * @brief The assets loaded by ParallelLoader::load(), kept loaded for as long
+ * as this object lives
+ */
+class LoadedGraph {
+    std::vector<FirmPtr<PolymorphicBase>> m_assets;
+    LoadReport m_report;
+
+  public:
+    LoadedGraph(std::vector<FirmPtr<PolymorphicBase>> &&assets,
+                const LoadReport &report)
+        : m_assets(std::move(assets)), m_report(report) {}
+
+    const LoadReport &report() const { return m_report; }
+    std::size_t size() const { return m_assets.size(); }
+};
+
+/**
+ * @brief Loads assets together with everything they depend on, constructing
+ * independent assets in parallel. Dependencies are discovered through the
+ * DependentSeedLike seeds, and each asset is loaded only after its
+ * dependencies, on a work-stealing pool of threads.
+ * Assets are constructed by their own pools, with their allocators
+ * @note All pools reachable from the roots must be safe to load from
+ * multiple threads, like ConcurrentCacher
+ * @example @code
+ *  ParallelLoader loader(8);
+ *  loader.add_root(level.meshes);
+ *  loader.add_root(level.materials);
+ *  LoadedGraph loaded = loader.load();
+ *  std::cout << loaded.report().critical_path.count();
+ * @endcode
+ */
+class ParallelLoader {
+    using RefCtr = PolymorphicReferenceCounter;
+    using Clock = std::chrono::steady_clock;
+
+    struct Node {
+        // keeps the counter alive while the graph is loaded
+        LazyPtr<PolymorphicBase> ptr;
+        std::vector<std::size_t> dependencies;
+        std::vector<std::size_t> dependents;
+    };
+
+    // a deque per worker. The owner works from the back, thieves from the
+    // front
+    struct alignas(64) WorkQueue {
+        std::mutex mutex;
+        std::deque<std::size_t> nodes;
+
+        void push(std::size_t node) {
+            std::lock_guard lock(mutex);
+            nodes.push_back(node);
+        }
+        std::optional<std::size_t> pop() {
+            std::lock_guard lock(mutex);
+            if (nodes.empty()) {
+                return std::nullopt;
+            }
+            std::size_t node = nodes.back();
+            nodes.pop_back();
+            return node;
+        }
+        std::optional<std::size_t> steal() {
+            std::lock_guard lock(mutex);
+            if (nodes.empty()) {
+                return std::nullopt;
+            }
+            std::size_t node = nodes.front();
+            nodes.pop_front();
+            return node;
+        }
+    };
+
+    // state shared by the workers of one load
+    struct Run {
+        std::vector<Node> &nodes;
+        std::unique_ptr<std::atomic<std::size_t>[]> pending;
+        std::unique_ptr<WorkQueue[]> queues;
+        std::size_t queue_count;
+        std::vector<std::optional<FirmPtr<PolymorphicBase>>> loaded;
+        std::vector<Clock::duration> times;
+        std::atomic<std::size_t> remaining;
+        std::atomic<bool> failed;
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        Clock::time_point last_finish;
+        std::mutex finish_mutex;
+
+        Run(std::vector<Node> &nodes, std::size_t queue_count)
+            : nodes(nodes),
+              pending(new std::atomic<std::size_t>[nodes.size()]),
+              queues(new WorkQueue[queue_count]), queue_count(queue_count),
+              loaded(nodes.size()), times(nodes.size()),
+              remaining(nodes.size()), failed(false) {}
+    };
+
+    std::size_t m_thread_count;
+    std::vector<LazyPtr<PolymorphicBase>> m_roots;
+
+    /**
+     * Finds all assets reachable from the roots, ordered so that each comes
+     * after its dependencies
+     * @throws std::invalid_argument if the dependencies form a cycle
+     */
+    std::vector<Node> discover() const {
+        std::vector<Node> nodes;
+        std::unordered_map<RefCtr *, std::size_t> indices;
+        // 0: unvisited, 1: on the stack, 2: finished
+        std::unordered_map<RefCtr *, int> marks;
+
+        struct Frame {
+            RefCtr *p_ctr;
+            std::vector<RefCtr *> dependencies;
+            std::size_t next;
+        };
+        std::vector<RefCtr *> collected;
+
+        for (const LazyPtr<PolymorphicBase> &root : m_roots) {
+            RefCtr *p_root = &internal::counterOf(root);
+            if (marks[p_root] != 0) {
+                continue;
+            }
+            std::vector<Frame> stack;
+            auto enter = [&](RefCtr *p_ctr) {
+                marks[p_ctr] = 1;
+                collected.clear();
+                p_ctr->collect_dependencies(collected);
+                stack.push_back(Frame{p_ctr, collected, 0});
+            };
+            enter(p_root);
+
+            while (!stack.empty()) {
+                Frame &frame = stack.back();
+                if (frame.next < frame.dependencies.size()) {
+                    RefCtr *p_dep = frame.dependencies[frame.next++];
+                    int mark = marks[p_dep];
+                    if (mark == 1) {
+                        throw std::invalid_argument(
+                            "The asset dependencies form a cycle");
+                    }
+                    if (mark == 0) {
+                        enter(p_dep);
+                    }
+                    continue;
+                }
+
+                // all dependencies are numbered, number this one
+                Node node{LazyPtr<PolymorphicBase>(*frame.p_ctr), {}, {}};
+                for (RefCtr *p_dep : frame.dependencies) {
+                    std::size_t dep = indices.at(p_dep);
+                    if (std::find(node.dependencies.begin(),
+                                  node.dependencies.end(),
+                                  dep) == node.dependencies.end()) {
+                        node.dependencies.push_back(dep);
+                    }
+                }
+                std::size_t index = nodes.size();
+                for (std::size_t dep : node.dependencies) {
+                    nodes[dep].dependents.push_back(index);
+                }
+                indices[frame.p_ctr] = index;
+                marks[frame.p_ctr] = 2;
+                nodes.push_back(std::move(node));
+                stack.pop_back();
+            }
+        }
+        return nodes;
+    }
+
+    static void work(Run &run, std::size_t self) {
+        std::size_t idle_rounds = 0;
+        while (run.remaining.load(std::memory_order_acquire) > 0 &&
+               !run.failed.load(std::memory_order_relaxed)) {
+            std::optional<std::size_t> node = run.queues[self].pop();
+            for (std::size_t i = 1; !node && i < run.queue_count; i++) {
+                node = run.queues[(self + i) % run.queue_count].steal();
+            }
+            if (!node) {
+                // nothing ready yet, wait for the running loads
+                if (++idle_rounds > 64) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                } else {
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+            idle_rounds = 0;
+
+            auto start = Clock::now();
+            try {
+                run.loaded[*node].emplace(
+                    internal::counterOf(run.nodes[*node].ptr));
+            } catch (...) {
+                std::lock_guard lock(run.error_mutex);
+                if (!run.error) {
+                    run.error = std::current_exception();
+                }
+                run.failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+            auto finish = Clock::now();
+            run.times[*node] = finish - start;
+            {
+                std::lock_guard lock(run.finish_mutex);
+                run.last_finish = std::max(run.last_finish, finish);
+            }
+
+            // our dependents that became ready are likely to use what we
+            // just loaded, so we take them ourselves
+            for (std::size_t dependent : run.nodes[*node].dependents) {
+                if (run.pending[dependent].fetch_sub(
+                        1, std::memory_order_acq_rel) == 1) {
+                    run.queues[self].push(dependent);
+                }
+            }
+            run.remaining.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+  public:
+    /**
+     * @param thread_count the number of threads loading assets, including
+     * the thread calling load()
+     */
+    ParallelLoader(std::size_t thread_count =
+                       std::max(1u, std::thread::hardware_concurrency()))
+        : m_thread_count(std::max<std::size_t>(thread_count, 1)) {}
+
+    /**
+     * @brief Adds an asset to load by the next load() call
+     */
+    template <class T> void add_root(const LazyPtr<T> &root) {
+        m_roots.emplace_back(internal::counterOf(root));
+    }
+    template <class T> void add_root(const std::vector<LazyPtr<T>> &roots) {
+        for (const LazyPtr<T> &root : roots) {
+            add_root(root);
+        }
+    }
+
+    /**
+     * @brief Loads the roots and all their dependencies, and clears the
+     * roots
+     * @returns the loaded assets, which stay loaded until it is destroyed
+     * @throws std::invalid_argument if the dependencies form a cycle
+     * @throws the first exception thrown by an asset's constructor. The
+     * assets loaded until then are released
+     */
+    LoadedGraph load() {
+        std::vector<Node> nodes = discover();
+        m_roots.clear();
+
+        std::size_t worker_count = std::min(m_thread_count, nodes.size());
+        if (worker_count == 0) {
+            return LoadedGraph({}, LoadReport{});
+        }
+        Run run(nodes, worker_count);
+
+        // distribute the leaves
+        std::size_t next_queue = 0;
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            run.pending[i].store(nodes[i].dependencies.size(),
+                                 std::memory_order_relaxed);
+            if (nodes[i].dependencies.empty()) {
+                run.queues[next_queue].nodes.push_back(i);
+                next_queue = (next_queue + 1) % worker_count;
+            }
+        }
+
+        auto start = Clock::now();
+        run.last_finish = start;
+        std::vector<std::thread> helpers;
+        for (std::size_t i = 1; i < worker_count; i++) {
+            helpers.emplace_back([&run, i]() { work(run, i); });
+        }
+        work(run, 0);
+        for (std::thread &helper : helpers) {
+            helper.join();
+        }
+        if (run.error) {
+            std::rethrow_exception(run.error);
+        }
+
+        LoadReport report;
+        report.asset_count = nodes.size();
+        report.wall_time = run.last_finish - start;
+
+        // nodes are ordered after their dependencies
+        std::vector<Clock::duration> path(nodes.size());
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            Clock::duration longest = Clock::duration::zero();
+            for (std::size_t dep : nodes[i].dependencies) {
+                longest = std::max(longest, path[dep]);
+            }
+            path[i] = longest + run.times[i];
+            report.total_work += run.times[i];
+            report.critical_path = std::max(report.critical_path, path[i]);
+        }
+
+        std::vector<FirmPtr<PolymorphicBase>> assets;
+        assets.reserve(nodes.size());
+        for (auto &loaded : run.loaded) {
+            assets.push_back(std::move(*loaded));
+        }
+        return LoadedGraph(std::move(assets), report);
+    }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_PARALLEL_LOADER_H
@@ -35,9 +35,25 @@ template <class To, class From>
 concept RawPointerCastable =
     PointerCastable<To, From> && RawConvertibleToPtr<From>;
 
+template <class T> class LazyPtr;
 template <class T> class FirmPtr;
+template <class T> class FirmRef;
 template <class PtrT> class OptionalPtrBase;
 
+namespace internal {
+
+/**
+ * @returns the type-erased counter behind the pointer, for pool
+ * implementations
+ */
+template <class T>
+PolymorphicReferenceCounter &counterOf(const LazyPtr<T> &ptr);
+
+// Selects the pointer constructors that take over an already raised count
+struct AdoptHoldTag {};
+
+} // namespace internal
+
 /**
  * @brief A lazy reference to an object. Doesn't ensure the object is loaded.
  * @note must be cast to a FirmPtr to access the object.
@@ -52,6 +68,8 @@ template <class T> class LazyPtr
     template <class O> friend class LazyPtr;
     template <class O> friend class FirmPtr;
     friend class OptionalPtrBase<LazyPtr<T>>;
+    template <class O>
+    friend PolymorphicReferenceCounter &internal::counterOf(const LazyPtr<O> &);
 
     RefCtr *m_p_ctr;
 
@@ -185,6 +203,26 @@ template <class T> class LazyPtr
             return FirmPtr<T>(internal::NULL_REF_CTR);
     }
 
+    /**
+     * @brief Accesses the object only if it is already loaded, without
+     * stalling on a load
+     * @returns a FirmPtr to the object if it was used or cached, nullopt
+     * otherwise
+     */
+    std::optional<FirmPtr<T>> try_get() const {
+        if (m_p_ctr == &internal::NULL_REF_CTR || !m_p_ctr->try_hold()) {
+            return std::nullopt;
+        }
+        return FirmPtr<T>(*m_p_ctr, &*dynamic_cast<T *>(m_p_ctr->p_get()),
+                          internal::AdoptHoldTag{});
+    }
+
+    /**
+     * @returns the version stamp of the asset, which changes when the asset
+     * is reloaded
+     */
+    std::size_t version() const { return m_p_ctr->version(); }
+
     // Comparison operators
 
     template <class O> bool operator==(const LazyPtr<O> &other) const {
@@ -202,6 +240,11 @@ template <class T> class LazyPtr
     }
 };
 
+template <class T>
+PolymorphicReferenceCounter &internal::counterOf(const LazyPtr<T> &ptr) {
+    return *ptr.m_p_ctr;
+}
+
 /**
  * @brief A firm reference to an object. Ensures the object is loaded.
  * @note Can be used like a pointer to the object.
@@ -216,6 +259,7 @@ template <class T> class FirmPtr
     template <class O> friend class LazyPtr;
     template <class O> friend class FirmPtr;
     template <class O> friend class PinPtr;
+    template <class O> friend class FirmRef;
     friend class OptionalPtrBase<FirmPtr<T>>;
 
     RefCtr *m_p_ctr;
@@ -228,6 +272,10 @@ template <class T> class FirmPtr
         m_p_ctr->hold();
     }
 
+    // Internal constructor for when the count was already raised for us
+    FirmPtr(RefCtr &ctr, T *p_object, internal::AdoptHoldTag)
+        : m_p_ctr(&ctr), m_p_object(p_object) {}
+
   public:
     // Internal constructor for managers
     // The ctr must produce instances derived from T, otherwise causes U.B.
@@ -426,6 +474,16 @@ template <class T> class FirmPtr
         return (void *)this->m_p_ctr <=> (void *)other.m_p_ctr;
     }
 
+    /**
+     * @returns whether the pointed object is still the current version of
+     * the asset, i.e. the asset wasn't reloaded since this pointer was made
+     * @note Pointers to older versions keep them alive, take a new FirmPtr
+     * from a LazyPtr to get the current one
+     */
+    bool is_current() const {
+        return dynamic_cast<T *>(m_p_ctr->p_get()) == m_p_object;
+    }
+
     // Dereferencing
 
     T &operator*() const { return *m_p_object; }
@@ -2,17 +2,56 @@
 #ifndef INCLUDED_DYNASMA_POOL_H
 #define INCLUDED_DYNASMA_POOL_H
 
+#include <chrono>
 #include <cstddef>
 #include <limits>
 
 namespace dynasma {
 
+/**
+ * @brief The order in which pools that support it unload cached assets
+ */
+enum class EvictionPolicy {
+    // the asset cached the longest ago first
+    Oldest,
+    // the asset with the highest memory cost multiplied by the time since its
+    // last use first
+    CostAware
+};
+
+/**
+ * @brief The memory taken by a pool, split into its assets and its own
+ * bookkeeping
+ */
+struct PoolMemory {
+    // total memory_cost() of the loaded assets
+    std::size_t asset_bytes = 0;
+    // estimated size of the counters, registry nodes, seed copies and
+    // indices, also of the registered assets that aren't loaded
+    std::size_t metadata_bytes = 0;
+
+    std::size_t total() const { return asset_bytes + metadata_bytes; }
+};
+
+namespace internal {
+
+// estimated heap overhead of a node of a std::list, besides its value
+inline constexpr std::size_t LIST_NODE_OVERHEAD = 2 * sizeof(void *);
+// estimated heap overhead of a node of a std::map, besides its value
+inline constexpr std::size_t MAP_NODE_OVERHEAD = 4 * sizeof(void *);
+
+} // namespace internal
+
 /**
  * @brief An abstract class for any kind of asset pool.
  * @note Cachers, Keepers and Managers all inherit from this asset type agnostic
  * class
  */
 class AbstractPool {
+  protected:
+    // whether clean() frees and counts the pool's bookkeeping too
+    bool m_count_metadata = false;
+
   public:
     /**
      * @brief Attempts to unload not-firmly-referenced assets to free memory
@@ -28,6 +67,50 @@ class AbstractPool {
     inline std::size_t cleanAll() {
         return clean(std::numeric_limits<std::size_t>::max());
     }
+
+    /**
+     * @brief Attempts to unload not-firmly-referenced assets to free memory,
+     * stopping early once the time budget is spent. Successive calls resume
+     * where the previous one stopped
+     * @param bytenum the number of bytes to attempt to free from memory
+     * @param budget the time after which no more assets will be unloaded.
+     * At least one asset is unloaded if possible, to ensure progress
+     * @returns the number of bytes freed (according to memory_cost() functions)
+     * @note Pools that can't split their cleanup ignore the budget
+     */
+    virtual std::size_t
+    clean_for(std::size_t bytenum,
+              [[maybe_unused]] std::chrono::steady_clock::duration budget) {
+        return clean(bytenum);
+    }
+
+    /**
+     * @brief Attempts to unload all not-firmly-referenced assets to free
+     * memory, stopping early once the time budget is spent
+     * @returns the number of bytes freed (according to memory_cost() functions)
+     */
+    template <class Rep, class Period>
+    std::size_t clean_for(std::chrono::duration<Rep, Period> budget) {
+        return clean_for(
+            std::numeric_limits<std::size_t>::max(),
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                budget));
+    }
+
+    /**
+     * @returns the memory taken by the loaded assets and by the pool itself
+     * @note Pools that don't track their memory report zeros
+     */
+    virtual PoolMemory memory_stats() { return PoolMemory{}; }
+
+    /**
+     * @brief Makes clean() count the pool's own bookkeeping towards the
+     * requested bytes. Once the unloadable assets are unloaded, it also
+     * frees the bookkeeping of the registered, but unloaded assets where the
+     * pool can, i.e. by compacting their seeds
+     * @note Disabled by default, when clean() counts only memory_cost()
+     */
+    void set_metadata_accounting(bool enabled) { m_count_metadata = enabled; }
 };
 } // namespace dynasma
 
@@ -0,0 +1,551 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_BATCHED_IO_H
+#define INCLUDED_DYNASMA_BATCHED_IO_H
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/util/construction.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace dynasma {
+
+/**
+ * @brief The contents of a read file, or the error that prevented reading it
+ */
+struct FileData {
+    std::vector<std::byte> bytes;
+    std::error_code error;
+};
+
+/**
+ * @brief Reads the whole file with blocking calls
+ */
+inline FileData readFile(const std::filesystem::path &path) {
+    FileData data;
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        data.error = std::error_code(errno, std::generic_category());
+        if (fd >= 0) {
+            close(fd);
+        }
+        return data;
+    }
+    data.bytes.resize(st.st_size);
+    std::size_t offset = 0;
+    while (offset < data.bytes.size()) {
+        ssize_t n = pread(fd, data.bytes.data() + offset,
+                          data.bytes.size() - offset, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            data.error = std::error_code(errno, std::generic_category());
+            break;
+        }
+        if (n == 0) {
+            // the file shrank
+            data.bytes.resize(offset);
+            break;
+        }
+        offset += n;
+    }
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(path, ec);
+    if (!file || ec) {
+        data.error = ec ? ec : std::make_error_code(std::errc::io_error);
+        return data;
+    }
+    data.bytes.resize(size);
+    file.read(reinterpret_cast<char *>(data.bytes.data()), size);
+    data.bytes.resize(file.gcount());
+#endif
+    return data;
+}
+
+#ifdef __linux__
+namespace internal {
+
+/**
+ * File descriptors, closed when this goes out of scope
+ */
+struct FileDescriptors {
+    std::vector<int> fds;
+
+    FileDescriptors(std::size_t count) : fds(count, -1) {}
+    FileDescriptors(const FileDescriptors &) = delete;
+    FileDescriptors &operator=(const FileDescriptors &) = delete;
+    ~FileDescriptors() {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+};
+
+} // namespace internal
+#endif
+
+/**
+ * @brief Reads many files in batches, to avoid a blocking call per read when
+ * loading many small assets.
+ * On Linux the reads of a batch are submitted together through io_uring, into
+ * buffers preallocated to the files' sizes. Where io_uring isn't available,
+ * the files are read with blocking calls on a few threads.
+ * Read files can be kept for FileSource kernels, whose assets then take their
+ * contents instead of reading them during construction
+ * @note read_all() and prefetch() are serialized, take() can be called from
+ * any thread
+ * @example @code
+ *  BatchedFileReader reader;
+ *  for (auto &path : scene.mesh_paths) {
+ *      meshes.push_back(manager.register_asset_k(FileSource{path, &reader}));
+ *  }
+ *  reader.prefetch(scene.mesh_paths);
+ *  for (auto &mesh : meshes) {
+ *      loaded.push_back(mesh.getLoaded()); // no reads here
+ *  }
+ * @endcode
+ */
+class BatchedFileReader {
+    std::size_t m_fallback_threads;
+    std::mutex m_batch_mutex;
+    std::mutex m_prefetched_mutex;
+    std::map<std::filesystem::path, FileData> m_prefetched;
+
+#ifdef __linux__
+    int m_ring_fd = -1;
+    unsigned m_sq_entries = 0;
+    void *m_p_sq_ring = MAP_FAILED;
+    std::size_t m_sq_ring_size = 0;
+    void *m_p_cq_ring = MAP_FAILED;
+    std::size_t m_cq_ring_size = 0;
+    io_uring_sqe *m_p_sqes = nullptr;
+    io_uring_params m_params = {};
+
+    template <class U> U *sq_field(std::uint32_t offset) {
+        return reinterpret_cast<U *>(static_cast<char *>(m_p_sq_ring) +
+                                     offset);
+    }
+    template <class U> U *cq_field(std::uint32_t offset) {
+        return reinterpret_cast<U *>(static_cast<char *>(m_p_cq_ring) +
+                                     offset);
+    }
+
+    bool setup_ring(unsigned queue_depth) {
+        m_ring_fd = syscall(__NR_io_uring_setup, queue_depth, &m_params);
+        if (m_ring_fd < 0) {
+            // likely an old kernel or a sandbox forbidding it
+            return false;
+        }
+        m_sq_entries = m_params.sq_entries;
+        m_sq_ring_size =
+            m_params.sq_off.array + m_params.sq_entries * sizeof(std::uint32_t);
+        m_cq_ring_size =
+            m_params.cq_off.cqes + m_params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = m_params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            m_sq_ring_size = m_cq_ring_size =
+                std::max(m_sq_ring_size, m_cq_ring_size);
+        }
+        m_p_sq_ring =
+            mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+        if (m_p_sq_ring == MAP_FAILED) {
+            return false;
+        }
+        m_p_cq_ring =
+            single_mmap
+                ? m_p_sq_ring
+                : mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, m_ring_fd,
+                       IORING_OFF_CQ_RING);
+        if (m_p_cq_ring == MAP_FAILED) {
+            return false;
+        }
+        void *p_sqes = mmap(nullptr, m_sq_entries * sizeof(io_uring_sqe),
+                            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            m_ring_fd, IORING_OFF_SQES);
+        if (p_sqes == MAP_FAILED) {
+            return false;
+        }
+        m_p_sqes = static_cast<io_uring_sqe *>(p_sqes);
+        return true;
+    }
+
+    void teardown_ring() {
+        if (m_p_sqes) {
+            munmap(m_p_sqes, m_sq_entries * sizeof(io_uring_sqe));
+            m_p_sqes = nullptr;
+        }
+        if (m_p_cq_ring != MAP_FAILED && m_p_cq_ring != m_p_sq_ring) {
+            munmap(m_p_cq_ring, m_cq_ring_size);
+        }
+        if (m_p_sq_ring != MAP_FAILED) {
+            munmap(m_p_sq_ring, m_sq_ring_size);
+        }
+        m_p_sq_ring = m_p_cq_ring = MAP_FAILED;
+        if (m_ring_fd >= 0) {
+            close(m_ring_fd);
+            m_ring_fd = -1;
+        }
+    }
+
+    void queue_read(int fd, std::byte *p_buffer, std::size_t size,
+                    std::size_t offset, std::size_t file_index) {
+        // we're the only producer, the kernel only reads the tail
+        std::uint32_t mask =
+            *sq_field<std::uint32_t>(m_params.sq_off.ring_mask);
+        std::atomic_ref<std::uint32_t> sq_tail(
+            *sq_field<std::uint32_t>(m_params.sq_off.tail));
+        std::uint32_t tail = sq_tail.load(std::memory_order_relaxed);
+        std::uint32_t index = tail & mask;
+
+        io_uring_sqe &sqe = m_p_sqes[index];
+        sqe = {};
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(p_buffer);
+        sqe.len = static_cast<std::uint32_t>(
+            std::min<std::size_t>(size, 1u << 30));
+        sqe.off = offset;
+        sqe.user_data = file_index;
+
+        sq_field<std::uint32_t>(m_params.sq_off.array)[index] = index;
+        sq_tail.store(tail + 1, std::memory_order_release);
+    }
+
+    int enter(unsigned to_submit, unsigned min_complete) {
+        for (;;) {
+            int ret = syscall(__NR_io_uring_enter, m_ring_fd, to_submit,
+                              min_complete, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret >= 0) {
+                return ret;
+            }
+            if (errno != EINTR) {
+                throw std::system_error(errno, std::generic_category(),
+                                        "io_uring_enter failed");
+            }
+        }
+    }
+
+    /**
+     * Takes the unsubmitted reads back from the SQ ring, and waits for the
+     * submitted ones to complete, as the kernel may still be writing into
+     * the results' buffers. If it can't wait, the buffers are leaked
+     */
+    void abandon_reads(std::vector<FileData> &results, unsigned unsubmitted,
+                       std::size_t submitted) {
+        // the kernel consumes SQ entries only inside io_uring_enter()
+        std::atomic_ref<std::uint32_t> sq_tail(
+            *sq_field<std::uint32_t>(m_params.sq_off.tail));
+        sq_tail.store(sq_tail.load(std::memory_order_relaxed) - unsubmitted,
+                      std::memory_order_release);
+
+        std::atomic_ref<std::uint32_t> cq_head(
+            *cq_field<std::uint32_t>(m_params.cq_off.head));
+        std::atomic_ref<std::uint32_t> cq_tail(
+            *cq_field<std::uint32_t>(m_params.cq_off.tail));
+        while (submitted > 0) {
+            int ret = syscall(__NR_io_uring_enter, m_ring_fd, 0, 1,
+                              IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0 && errno != EINTR) {
+                // can't tell when the reads stop, so the buffers must
+                // outlive us
+                new std::vector<FileData>(std::move(results));
+                return;
+            }
+            std::uint32_t head = cq_head.load(std::memory_order_relaxed);
+            std::uint32_t tail = cq_tail.load(std::memory_order_acquire);
+            submitted -= tail - head;
+            cq_head.store(tail, std::memory_order_release);
+        }
+    }
+
+    std::vector<FileData>
+    read_all_ring(std::span<const std::filesystem::path> paths) {
+        std::vector<FileData> results(paths.size());
+        internal::FileDescriptors files(paths.size());
+        std::vector<int> &fds = files.fds;
+        std::vector<std::size_t> offsets(paths.size(), 0);
+        // indices of files with bytes left to queue
+        std::vector<std::size_t> pending;
+
+        for (std::size_t i = 0; i < paths.size(); i++) {
+            int fd = open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) < 0) {
+                results[i].error =
+                    std::error_code(errno, std::generic_category());
+                if (fd >= 0) {
+                    close(fd);
+                }
+                continue;
+            }
+            fds[i] = fd;
+            results[i].bytes.resize(st.st_size);
+            if (st.st_size > 0) {
+                pending.push_back(i);
+            }
+        }
+        std::reverse(pending.begin(), pending.end());
+
+        std::uint32_t cq_mask =
+            *cq_field<std::uint32_t>(m_params.cq_off.ring_mask);
+        io_uring_cqe *p_cqes = cq_field<io_uring_cqe>(m_params.cq_off.cqes);
+        std::atomic_ref<std::uint32_t> cq_head(
+            *cq_field<std::uint32_t>(m_params.cq_off.head));
+        std::atomic_ref<std::uint32_t> cq_tail(
+            *cq_field<std::uint32_t>(m_params.cq_off.tail));
+
+        std::size_t in_flight = 0;
+        unsigned unsubmitted = 0;
+        try {
+            while (!pending.empty() || in_flight > 0) {
+                // fill the queue, while keeping completions within the CQ ring
+                while (!pending.empty() && in_flight < m_sq_entries) {
+                    std::size_t i = pending.back();
+                    pending.pop_back();
+                    queue_read(fds[i], results[i].bytes.data() + offsets[i],
+                               results[i].bytes.size() - offsets[i], offsets[i],
+                               i);
+                    in_flight++;
+                    unsubmitted++;
+                }
+                unsubmitted -= enter(unsubmitted, 1);
+
+                std::uint32_t head = cq_head.load(std::memory_order_relaxed);
+                std::uint32_t tail = cq_tail.load(std::memory_order_acquire);
+                for (; head != tail; head++) {
+                    const io_uring_cqe &cqe = p_cqes[head & cq_mask];
+                    std::size_t i = cqe.user_data;
+                    in_flight--;
+                    if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                        pending.push_back(i);
+                    } else if (cqe.res < 0) {
+                        results[i].error =
+                            std::error_code(-cqe.res, std::generic_category());
+                        results[i].bytes.clear();
+                    } else if (cqe.res == 0) {
+                        // the file shrank
+                        results[i].bytes.resize(offsets[i]);
+                    } else {
+                        offsets[i] += cqe.res;
+                        if (offsets[i] < results[i].bytes.size()) {
+                            // a short read, queue the rest
+                            pending.push_back(i);
+                        }
+                    }
+                }
+                cq_head.store(head, std::memory_order_release);
+            }
+        } catch (const std::system_error &) {
+            abandon_reads(results, unsubmitted, in_flight - unsubmitted);
+            teardown_ring();
+            return read_all_threaded(paths);
+        } catch (...) {
+            abandon_reads(results, unsubmitted, in_flight - unsubmitted);
+            throw;
+        }
+        return results;
+    }
+#endif
+
+    std::vector<FileData>
+    read_all_threaded(std::span<const std::filesystem::path> paths) {
+        std::vector<FileData> results(paths.size());
+        std::atomic<std::size_t> next = 0;
+        auto work = [&]() {
+            for (std::size_t i; (i = next.fetch_add(1)) < paths.size();) {
+                results[i] = readFile(paths[i]);
+            }
+        };
+        std::vector<std::jthread> workers;
+        std::size_t thread_count =
+            std::min<std::size_t>(m_fallback_threads, paths.size());
+        for (std::size_t t = 1; t < thread_count; t++) {
+            workers.emplace_back(work);
+        }
+        work();
+        return results;
+    }
+
+  public:
+    BatchedFileReader(const BatchedFileReader &) = delete;
+    BatchedFileReader &operator=(const BatchedFileReader &) = delete;
+
+    /**
+     * @param queue_depth the maximum number of reads in flight, 0 to always
+     * use the fallback threads
+     * @param fallback_threads the number of threads reading files when
+     * io_uring isn't available
+     */
+    BatchedFileReader(unsigned queue_depth = 256,
+                      std::size_t fallback_threads = 4)
+        : m_fallback_threads(std::max<std::size_t>(fallback_threads, 1)) {
+#ifdef __linux__
+        if (queue_depth > 0 && !setup_ring(queue_depth)) {
+            teardown_ring();
+        }
+#endif
+    }
+    ~BatchedFileReader() {
+#ifdef __linux__
+        teardown_ring();
+#endif
+    }
+
+    /**
+     * @returns whether the reads are submitted through io_uring
+     */
+    bool uses_io_uring() const {
+#ifdef __linux__
+        return m_ring_fd >= 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Reads all the files, in batches
+     * @returns the files' contents or errors, in the order of the paths
+     * @note If io_uring fails to submit a batch, the reader waits for the
+     * batch's submitted reads, and reads with the fallback threads from then
+     * on
+     */
+    std::vector<FileData>
+    read_all(std::span<const std::filesystem::path> paths) {
+        std::lock_guard lock(m_batch_mutex);
+#ifdef __linux__
+        if (m_ring_fd >= 0) {
+            return read_all_ring(paths);
+        }
+#endif
+        return read_all_threaded(paths);
+    }
+
+    /**
+     * @brief Reads all the files in batches, and keeps their contents until
+     * they are taken
+     */
+    void prefetch(std::span<const std::filesystem::path> paths) {
+        std::vector<FileData> results = read_all(paths);
+        std::lock_guard lock(m_prefetched_mutex);
+        for (std::size_t i = 0; i < paths.size(); i++) {
+            m_prefetched.insert_or_assign(paths[i], std::move(results[i]));
+        }
+    }
+
+    /**
+     * @returns the prefetched contents of the file, which are no longer kept,
+     * or nullopt if the file wasn't prefetched
+     */
+    std::optional<FileData> take(const std::filesystem::path &path) {
+        std::lock_guard lock(m_prefetched_mutex);
+        auto it = m_prefetched.find(path);
+        if (it == m_prefetched.end()) {
+            return std::nullopt;
+        }
+        FileData data = std::move(it->second);
+        m_prefetched.erase(it);
+        return data;
+    }
+
+    /**
+     * @returns the number of kept files that weren't taken yet
+     */
+    std::size_t prefetched_count() {
+        std::lock_guard lock(m_prefetched_mutex);
+        return m_prefetched.size();
+    }
+};
+
+/**
+ * An asset constructible from a file's contents, moved into its constructor
+ * as a std::vector<std::byte>
+ */
+template <class T>
+concept FileConstructible =
+    std::constructible_from<T, std::vector<std::byte> &&> ||
+    std::constructible_from<T, PolymorphicReferenceCounter *,
+                            std::vector<std::byte> &&>;
+
+/**
+ * @brief A seed kernel for FileConstructible assets.
+ * If the reader prefetched the file, the asset takes the read contents,
+ * otherwise the file is read during the construction
+ * @note Compared and ordered by the path only
+ */
+struct FileSource {
+    std::filesystem::path path;
+    BatchedFileReader *p_reader = nullptr;
+
+    bool operator==(const FileSource &other) const {
+        return path == other.path;
+    }
+    auto operator<=>(const FileSource &other) const {
+        return path <=> other.path;
+    }
+};
+
+/**
+ * @brief Constructs the object from the file's contents
+ * @throws std::system_error if the file couldn't be read
+ */
+template <class T, class Ctr>
+void constructObject(T *p, Ctr &ctr, const FileSource &source)
+    requires FileConstructible<T>
+{
+    std::optional<FileData> data;
+    if (source.p_reader) {
+        data = source.p_reader->take(source.path);
+    }
+    if (!data) {
+        data = readFile(source.path);
+    }
+    if (data->error) {
+        throw std::system_error(data->error, source.path.string());
+    }
+    constructObject(p, ctr, std::move(data->bytes));
+}
+
+namespace internal {
+
+template <class T> struct ConstructibleFromKernel_type<T, FileSource> {
+    static constexpr bool value = FileConstructible<T>;
+};
+
+} // namespace internal
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_BATCHED_IO_H
@@ -0,0 +1,208 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_CHUNKED_H
+#define INCLUDED_DYNASMA_CHUNKED_H
+
+#include "dynasma/core_concepts.hpp"
+#include "dynasma/util/construction.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <semaphore>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dynasma {
+
+/**
+ * A reader of an asset's source data, read sequentially in chunks.
+ * Must have a method read() filling the start of the given buffer and
+ * returning the number of bytes read, 0 at the end of the data.
+ * @example @code
+ *  struct MyFileReader {
+ *      std::ifstream file;
+ *
+ *      std::size_t read(std::span<std::byte> buffer);
+ *  }
+ * @endcode
+ */
+template <class R>
+concept ChunkReaderLike = requires(R &reader, std::span<std::byte> buffer) {
+    { reader.read(buffer) } -> std::convertible_to<std::size_t>;
+};
+
+/**
+ * An asset built incrementally from chunks of its source data, so the whole
+ * source never needs to be in memory.
+ * Must have a default constructible Builder type with a method consume()
+ * taking each chunk in order, and be constructible from the finished Builder.
+ * @example @code
+ *  struct MyMesh: public PolymorphicBase {
+ *      struct Builder {
+ *          std::vector<Vertex> vertices;
+ *
+ *          void consume(std::span<const std::byte> chunk);
+ *      };
+ *
+ *      MyMesh(Builder &&builder);
+ *      std::size_t memory_cost() const;
+ *  }
+ * @endcode
+ */
+template <class T>
+concept ChunkBuildable =
+    std::default_initializable<typename T::Builder> &&
+    std::constructible_from<T, typename T::Builder &&> &&
+    requires(typename T::Builder &builder, std::span<const std::byte> chunk) {
+        builder.consume(chunk);
+    };
+
+/**
+ * @brief Thrown when the construction of a chunked asset is cancelled.
+ * The asset stays unloaded
+ */
+class LoadCancelled : public std::exception {
+  public:
+    const char *what() const noexcept override {
+        return "The asset's loading was cancelled";
+    }
+};
+
+/**
+ * @brief A seed kernel for ChunkBuildable assets. Opens a new reader for each
+ * construction, and feeds the asset's Builder chunk by chunk. The next chunk
+ * is read on another thread while the current one is consumed, into one of
+ * two buffers of chunk_size bytes, which bounds the memory used for reading.
+ * Construction stops between chunks, throwing LoadCancelled, once a stop is
+ * requested through stop_token
+ * @tparam Open a copyable callable returning a ChunkReaderLike reader
+ */
+template <class Open>
+    requires ChunkReaderLike<std::invoke_result_t<const Open &>>
+struct ChunkedSource {
+    Open open;
+    std::size_t chunk_size = 1 << 20;
+    std::stop_token stop_token = {};
+};
+
+namespace internal {
+
+/**
+ * Reads chunks ahead into two alternating buffers on its own thread
+ */
+template <class Reader> class ChunkPrefetcher {
+    Reader &m_reader;
+    std::vector<std::byte> m_buffers[2];
+    std::size_t m_sizes[2];
+    // the destructor can release a free buffer twice
+    std::counting_semaphore<2> m_free[2]{std::counting_semaphore<2>(1),
+                                         std::counting_semaphore<2>(1)};
+    std::binary_semaphore m_filled[2]{std::binary_semaphore(0),
+                                      std::binary_semaphore(0)};
+    std::exception_ptr m_error;
+    std::size_t m_next;
+    // declared last, so it's joined before the buffers are destroyed
+    std::jthread m_thread;
+
+    void read_ahead(std::stop_token stop) {
+        for (std::size_t i = 0;; i++) {
+            std::size_t slot = i % 2;
+            m_free[slot].acquire();
+            if (stop.stop_requested()) {
+                return;
+            }
+            try {
+                m_sizes[slot] = m_reader.read(m_buffers[slot]);
+            } catch (...) {
+                m_error = std::current_exception();
+                m_sizes[slot] = 0;
+            }
+            bool finished = m_sizes[slot] == 0;
+            m_filled[slot].release();
+            if (finished) {
+                return;
+            }
+        }
+    }
+
+  public:
+    ChunkPrefetcher(Reader &reader, std::size_t chunk_size)
+        : m_reader(reader), m_buffers{std::vector<std::byte>(chunk_size),
+                                      std::vector<std::byte>(chunk_size)},
+          m_next(0),
+          m_thread([this](std::stop_token stop) { read_ahead(stop); }) {}
+
+    ~ChunkPrefetcher() {
+        // wake the reader if it waits for a buffer we won't return
+        m_thread.request_stop();
+        m_free[0].release();
+        m_free[1].release();
+    }
+
+    /**
+     * @returns the next chunk, empty at the end of the data. Valid until the
+     * next call
+     * @throws what the reader threw
+     */
+    std::span<const std::byte> next() {
+        if (m_next > 0) {
+            // return the previous chunk's buffer to the reader
+            m_free[(m_next - 1) % 2].release();
+        }
+        std::size_t slot = m_next++ % 2;
+        m_filled[slot].acquire();
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+        return std::span<const std::byte>(m_buffers[slot].data(),
+                                          m_sizes[slot]);
+    }
+};
+
+} // namespace internal
+
+/**
+ * @brief Constructs a ChunkBuildable object from the chunks of its source.
+ * The object is constructed only after the last chunk, from the Builder
+ * @throws LoadCancelled if a stop was requested before the last chunk
+ */
+template <class T, class Ctr, class Open>
+void constructObject(T *p, Ctr &ctr, const ChunkedSource<Open> &source)
+    requires ChunkBuildable<T>
+{
+    auto reader = source.open();
+    typename T::Builder builder;
+    {
+        internal::ChunkPrefetcher<decltype(reader)> prefetcher(
+            reader, source.chunk_size);
+        for (;;) {
+            if (source.stop_token.stop_requested()) {
+                throw LoadCancelled();
+            }
+            std::span<const std::byte> chunk = prefetcher.next();
+            if (chunk.empty()) {
+                break;
+            }
+            builder.consume(chunk);
+        }
+    }
+    constructObject(p, ctr, std::move(builder));
+}
+
+namespace internal {
+
+template <class T, class Open>
+struct ConstructibleFromKernel_type<T, ChunkedSource<Open>> {
+    static constexpr bool value = ChunkBuildable<T>;
+};
+
+} // namespace internal
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_CHUNKED_H
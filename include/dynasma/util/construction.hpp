@@ -6,7 +6,11 @@
 #include "dynasma/core_concepts.hpp"
 #include "dynasma/util/ref_management.hpp"
 
+#include <cstddef>
 #include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace dynasma {
 
@@ -24,8 +28,129 @@ void constructObject(T *p, Ctr &ctr, ArgTs &&...args)
     new (p) T(&ctr, std::forward<ArgTs>(args)...);
 }
 
+namespace internal {
+
+template <class T, class Ctr, class VariantT, std::size_t... Is>
+void constructFromAlternative(T *p, Ctr &ctr, const VariantT &kernel,
+                              std::index_sequence<Is...>) {
+    // a flat chain of index compares, which compiles to a single jump table
+    (void)((kernel.index() == Is &&
+            (constructObject(p, ctr, *std::get_if<Is>(&kernel)), true)) ||
+           ...);
+}
+
+} // namespace internal
+
+/**
+ * @brief Constructs the object from a seed kernel, choosing the constructor
+ * at compile time where possible.
+ * Plain kernels and single-alternative variants call the constructor
+ * directly, other variants switch on the alternative index.
+ * @throws std::bad_variant_access if the kernel is a valueless variant
+ */
+template <class T, class Ctr, class Kernel>
+void constructFromKernel(T *p, Ctr &ctr, const Kernel &kernel) {
+    if constexpr (!internal::IsVariant<Kernel>::value) {
+        constructObject(p, ctr, kernel);
+    } else if (kernel.valueless_by_exception()) {
+        // as std::visit() would
+        throw std::bad_variant_access();
+    } else if constexpr (std::variant_size_v<Kernel> == 1) {
+        constructObject(p, ctr, *std::get_if<0>(&kernel));
+    } else {
+        internal::constructFromAlternative(
+            p, ctr, kernel,
+            std::make_index_sequence<std::variant_size_v<Kernel>>{});
+    }
+}
+
+/**
+ * @brief Appends the counters of the seed's declared dependencies, if it
+ * declares any
+ */
+template <class Seed>
+void collectSeedDependencies(const Seed &seed,
+                             std::vector<PolymorphicReferenceCounter *> &out) {
+    if constexpr (DependentSeedLike<Seed>) {
+        for (const auto &dependency : seed.dependencies()) {
+            out.push_back(&internal::counterOf(dependency));
+        }
+    }
+}
+
+/**
+ * @returns the number of bytes the seed owns besides its own size, if it
+ * reports them, otherwise 0
+ */
+template <class Seed> std::size_t seedMemoryCost(const Seed &seed) {
+    if constexpr (CompactableSeedLike<Seed>) {
+        return seed.memory_cost();
+    } else {
+        return 0;
+    }
+}
+
+/**
+ * @brief Frees what the seed doesn't need to construct its asset, if it can
+ * @returns the number of freed bytes
+ */
+template <class Seed> std::size_t compactSeed(Seed &seed) {
+    if constexpr (CompactableSeedLike<Seed>) {
+        return seed.compact();
+    } else {
+        return 0;
+    }
+}
+
+/**
+ * @brief Allocates one object, placed near p_hint if the allocator takes
+ * locality hints
+ */
+template <class Alloc>
+typename std::allocator_traits<Alloc>::pointer
+allocateNear(Alloc &allocator, const void *p_hint) {
+    if constexpr (AllocatorWLocality<Alloc>) {
+        using const_void_pointer =
+            typename std::allocator_traits<Alloc>::const_void_pointer;
+        return allocator.allocate(1, static_cast<const_void_pointer>(p_hint));
+    } else {
+        return allocator.allocate(1);
+    }
+}
+
+/**
+ * @returns where the seed's asset should be placed: near the first loaded
+ * asset it depends on, as they are likely accessed together, or else near
+ * its counter
+ */
+template <class Seed>
+const void *localityHint(const Seed &seed,
+                         const PolymorphicReferenceCounter &ctr) {
+    if constexpr (DependentSeedLike<Seed>) {
+        for (const auto &dependency : seed.dependencies()) {
+            if (const void *p = internal::counterOf(dependency).p_get()) {
+                return p;
+            }
+        }
+    }
+    return &ctr;
+}
+
 template <class T> void destroyObject(T *p) { p->~T(); }
 
+/**
+ * @brief Destroys an object and returns its memory to the allocator.
+ * Matches DestructionQueue::DestroyFn, for deferring unloads
+ * @tparam Alloc the allocator type, whose value_type is the object's type
+ */
+template <class Alloc>
+void destroyAndDeallocate(void *p_allocator, void *p_object) {
+    using T = typename Alloc::value_type;
+    T *p = static_cast<T *>(p_object);
+    destroyObject(p);
+    static_cast<Alloc *>(p_allocator)->deallocate(p, 1);
+}
+
 } // namespace dynasma
 
 #endif // INCLUDED_DYNASMA_CONSTRUCTION_H
\ No newline at end of file
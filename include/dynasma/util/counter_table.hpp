@@ -0,0 +1,271 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_COUNTER_TABLE_H
+#define INCLUDED_DYNASMA_COUNTER_TABLE_H
+
+#include "dynasma/util/victim_selection.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dynasma {
+
+/**
+ * @brief Structure-of-arrays bookkeeping of a pool's counters. Keeps the
+ * state and memory cost of each counter in contiguous arrays, so that
+ * statistics and cleanup decisions can scan them without touching the
+ * counters or the assets.
+ * Also tracks when each asset was last used, for cost-aware eviction
+ * @tparam Ctr the pool's counter type
+ */
+template <class Ctr> class CounterTable {
+  public:
+    using Slot = std::uint32_t;
+
+    /**
+     * @brief The object state of the counter in the slot, or Free if the
+     * slot is unused
+     */
+    enum class State : std::uint8_t { Free, Unloaded, Cached, Used };
+
+  private:
+    std::vector<Ctr *> m_counters;
+    std::vector<std::size_t> m_costs;
+    std::vector<State> m_states;
+    std::vector<Slot> m_free_slots;
+
+    // eviction weight (non-zero only for cached slots) and last use time
+    std::vector<std::uint32_t> m_weights;
+    std::vector<std::uint32_t> m_last_uses;
+    std::uint32_t m_clock = 0;
+
+    // kept up to date, so eviction can size its batches without a scan
+    std::size_t m_cached_count = 0;
+    std::size_t m_cached_cost = 0;
+
+    // the fewest victims selected per scan of the table
+    static constexpr std::size_t MIN_VICTIM_BATCH = 32;
+
+    void update_weight(Slot slot) {
+        if (m_states[slot] != State::Cached) {
+            m_weights[slot] = 0;
+            return;
+        }
+        // +1 so that free-to-keep assets can still be evicted
+        m_weights[slot] =
+            (std::uint32_t)std::min<std::size_t>(m_costs[slot],
+                                                 MAX_VICTIM_WEIGHT - 1) +
+            1;
+    }
+
+    std::size_t sum_costs(State state) const {
+        // branchless, so the compiler can vectorize it
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < m_costs.size(); i++) {
+            sum += m_costs[i] & -(std::size_t)(m_states[i] == state);
+        }
+        return sum;
+    }
+
+    // adds or subtracts the slot from the cached totals, if it is cached
+    void tally_cached(Slot slot, bool add) {
+        if (m_states[slot] == State::Cached) {
+            if (add) {
+                m_cached_count++;
+                m_cached_cost += m_costs[slot];
+            } else {
+                m_cached_count--;
+                m_cached_cost -= m_costs[slot];
+            }
+        }
+    }
+
+  public:
+    /**
+     * @brief Gives a slot to a new counter, in the Unloaded state
+     */
+    Slot add(Ctr &ctr) {
+        if (!m_free_slots.empty()) {
+            Slot slot = m_free_slots.back();
+            m_free_slots.pop_back();
+            m_counters[slot] = &ctr;
+            m_costs[slot] = 0;
+            m_states[slot] = State::Unloaded;
+            m_last_uses[slot] = m_clock;
+            return slot;
+        }
+        m_counters.push_back(&ctr);
+        m_costs.push_back(0);
+        m_states.push_back(State::Unloaded);
+        m_weights.push_back(0);
+        m_last_uses.push_back(m_clock);
+        return (Slot)(m_counters.size() - 1);
+    }
+
+    /**
+     * @brief Frees the slot of a forgotten counter
+     */
+    void remove(Slot slot) {
+        tally_cached(slot, false);
+        m_counters[slot] = nullptr;
+        m_costs[slot] = 0;
+        m_states[slot] = State::Free;
+        m_weights[slot] = 0;
+        m_free_slots.push_back(slot);
+    }
+
+    void set_state(Slot slot, State state) {
+        tally_cached(slot, false);
+        m_states[slot] = state;
+        tally_cached(slot, true);
+        update_weight(slot);
+    }
+    State state(Slot slot) const { return m_states[slot]; }
+
+    /**
+     * @brief Sets the memory cost charged for the slot's asset.
+     * 0 for unloaded assets
+     */
+    void set_cost(Slot slot, std::size_t cost) {
+        tally_cached(slot, false);
+        m_costs[slot] = cost;
+        tally_cached(slot, true);
+        update_weight(slot);
+    }
+    std::size_t cost(Slot slot) const { return m_costs[slot]; }
+
+    Ctr &counter(Slot slot) const { return *m_counters[slot]; }
+
+    /**
+     * @brief Marks the slot's asset as used just now
+     */
+    void touch(Slot slot) { m_last_uses[slot] = ++m_clock; }
+
+    /**
+     * @brief Finds the cached slots most worth evicting, scoring each by its
+     * memory cost multiplied by the time since it was last used
+     * @returns the number of victims stored in p_out, best first
+     */
+    std::size_t select_victims(Victim *p_out, std::size_t k) const {
+        return selectVictims(m_weights.data(), m_last_uses.data(),
+                             m_weights.size(), m_clock, p_out, k);
+    }
+
+    /**
+     * @brief Unloads the cached slots most worth evicting, best first, until
+     * the given number of bytes is freed or should_stop() returns true.
+     * Each scan selects enough victims to free the remaining bytes at the
+     * average cached cost, at least twice as many as the previous scan, so
+     * that large cleanups scan the table only a few times
+     * @param unload unloads the counter's asset, returning the freed bytes.
+     * It may forget or hold other counters, which are then skipped
+     * @param should_stop checked after each unload
+     * @returns the number of freed bytes
+     */
+    template <class Unload, class Stop>
+    std::size_t unload_victims(std::size_t bytenum, Unload &&unload,
+                               Stop &&should_stop) {
+        std::size_t bFreed = 0;
+        std::size_t batch = 0;
+        std::vector<Victim> victims;
+        while (bFreed < bytenum) {
+            if (m_cached_count == 0) {
+                break;
+            }
+            std::size_t averageCost =
+                std::max<std::size_t>(m_cached_cost / m_cached_count, 1);
+            std::size_t needed = (bytenum - bFreed) / averageCost + 1;
+            batch = std::min(std::max({needed, 2 * batch, MIN_VICTIM_BATCH}),
+                             m_cached_count);
+            victims.resize(batch);
+            std::size_t n = select_victims(victims.data(), batch);
+            for (std::size_t i = 0; i < n && bFreed < bytenum; i++) {
+                Slot slot = victims[i].slot;
+                // an earlier victim's destructor can forget or hold it
+                if (m_states[slot] != State::Cached) {
+                    continue;
+                }
+                bFreed += unload(*m_counters[slot]);
+                if (should_stop()) {
+                    return bFreed;
+                }
+            }
+        }
+        return bFreed;
+    }
+
+    /**
+     * @returns the total memory cost of the cached assets, without a scan
+     */
+    std::size_t cached_cost() const { return m_cached_cost; }
+
+    /**
+     * @returns the total memory cost of the assets in the given state
+     */
+    std::size_t memory(State state) const { return sum_costs(state); }
+
+    /**
+     * @returns the number of counters in the given state
+     */
+    std::size_t count(State state) const {
+        std::size_t count = 0;
+        for (State s : m_states) {
+            count += (s == state);
+        }
+        return count;
+    }
+
+    /**
+     * @returns the number of slots, including free ones
+     */
+    std::size_t capacity() const { return m_states.size(); }
+
+    /**
+     * @returns the number of bytes taken by the arrays
+     */
+    std::size_t memory_footprint() const {
+        return m_counters.capacity() * sizeof(Ctr *) +
+               m_costs.capacity() * sizeof(std::size_t) +
+               m_states.capacity() * sizeof(State) +
+               m_free_slots.capacity() * sizeof(Slot) +
+               (m_weights.capacity() + m_last_uses.capacity()) *
+                   sizeof(std::uint32_t);
+    }
+
+    /**
+     * @brief Drops the free slots at the end and releases the arrays' unused
+     * capacity
+     * @returns the number of freed bytes
+     */
+    std::size_t shrink() {
+        std::size_t before = memory_footprint();
+        std::size_t size = m_states.size();
+        while (size > 0 && m_states[size - 1] == State::Free) {
+            size--;
+        }
+        m_counters.resize(size);
+        m_costs.resize(size);
+        m_states.resize(size);
+        m_weights.resize(size);
+        m_last_uses.resize(size);
+        std::erase_if(m_free_slots, [&](Slot slot) { return slot >= size; });
+        m_counters.shrink_to_fit();
+        m_costs.shrink_to_fit();
+        m_states.shrink_to_fit();
+        m_free_slots.shrink_to_fit();
+        m_weights.shrink_to_fit();
+        m_last_uses.shrink_to_fit();
+        return before - memory_footprint();
+    }
+
+    /**
+     * @returns contiguous views of the arrays, for custom scans
+     */
+    const std::size_t *costs() const { return m_costs.data(); }
+    const State *states() const { return m_states.data(); }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_COUNTER_TABLE_H
@@ -0,0 +1,184 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_DEFERRED_DESTRUCTION_H
+#define INCLUDED_DYNASMA_DEFERRED_DESTRUCTION_H
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace dynasma {
+
+/**
+ * @brief A queue of asset destructions, handed over by pools so that the
+ * destructors and deallocations don't run on the thread that triggered them.
+ * The queue can be drained in batches at a chosen point (i.e. between frames),
+ * or by a background worker thread.
+ * @note All pools using the queue must be cleaned and the queue drained before
+ * the pools are destroyed, just like cleaning the pools themselves
+ * @note When using the worker thread, the asset destructors and the pools'
+ * allocators must be safe to call from another thread. In particular, assets
+ * that drop pointers to other assets on destruction must be drained on the
+ * thread owning those assets' pools
+ */
+class DestructionQueue {
+  public:
+    /**
+     * Destroys and deallocates p_object, using the pool-specific p_context
+     */
+    using DestroyFn = void (*)(void *p_context, void *p_object);
+
+  private:
+    struct Job {
+        DestroyFn destroy;
+        void *p_context;
+        void *p_object;
+    };
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    // in push order, which all draining paths keep
+    std::deque<Job> m_jobs;
+    // number of queued jobs that haven't finished yet, including in-flight ones
+    std::size_t m_pending;
+
+    std::thread m_worker;
+    bool m_stopping;
+
+    // runs the jobs outside the lock
+    std::size_t run(std::deque<Job> &jobs) {
+        for (const Job &job : jobs) {
+            job.destroy(job.p_context, job.p_object);
+        }
+        std::size_t count = jobs.size();
+        jobs.clear();
+
+        std::lock_guard lock(m_mutex);
+        m_pending -= count;
+        return count;
+    }
+
+    void work() {
+        std::deque<Job> batch;
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            m_cv.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                return; // stopping
+            }
+            batch.swap(m_jobs);
+            lock.unlock();
+            run(batch);
+            lock.lock();
+        }
+    }
+
+  public:
+    DestructionQueue() : m_pending(0), m_stopping(false) {}
+    DestructionQueue(const DestructionQueue &) = delete;
+    DestructionQueue &operator=(const DestructionQueue &) = delete;
+    ~DestructionQueue() {
+        stop_worker();
+        assert(m_pending == 0);
+    }
+
+    /**
+     * @brief Queues a destruction
+     * @note Thread safe
+     */
+    void push(DestroyFn destroy, void *p_context, void *p_object) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_jobs.push_back(Job{destroy, p_context, p_object});
+            m_pending++;
+        }
+        if (m_worker.joinable()) {
+            m_cv.notify_one();
+        }
+    }
+
+    /**
+     * @brief Runs all queued destructions on the calling thread
+     * @returns the number of destroyed objects
+     */
+    std::size_t drain() {
+        std::deque<Job> batch;
+        {
+            std::lock_guard lock(m_mutex);
+            batch.swap(m_jobs);
+        }
+        return run(batch);
+    }
+
+    /**
+     * @brief Runs queued destructions on the calling thread until the queue is
+     * empty or the time budget is spent. At least one destruction is run if
+     * any are queued
+     * @returns the number of destroyed objects
+     */
+    std::size_t drain_for(std::chrono::steady_clock::duration budget) {
+        auto deadline = std::chrono::steady_clock::now() + budget;
+        std::size_t count = 0;
+        while (true) {
+            Job job;
+            {
+                std::lock_guard lock(m_mutex);
+                if (m_jobs.empty()) {
+                    return count;
+                }
+                job = m_jobs.front();
+                m_jobs.pop_front();
+            }
+            job.destroy(job.p_context, job.p_object);
+            count++;
+            {
+                std::lock_guard lock(m_mutex);
+                m_pending--;
+            }
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return count;
+            }
+        }
+    }
+
+    /**
+     * @brief Starts a background thread that runs destructions as soon as
+     * they are queued
+     */
+    void start_worker() {
+        assert(!m_worker.joinable());
+        m_stopping = false;
+        m_worker = std::thread([this] { work(); });
+    }
+
+    /**
+     * @brief Finishes the queued destructions and stops the background
+     * thread, if it is running
+     */
+    void stop_worker() {
+        if (!m_worker.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_one();
+        m_worker.join();
+    }
+
+    /**
+     * @returns the number of queued or in-progress destructions
+     */
+    std::size_t size() {
+        std::lock_guard lock(m_mutex);
+        return m_pending;
+    }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_DEFERRED_DESTRUCTION_H
@@ -13,6 +13,13 @@ Depends on the compiler
 #define DYNASMA_NO_UNIQUE_ADDRESS no_unique_address
 #endif
 
+/*
+Define DYNASMA_CONCURRENT_COUNTERS for the whole program to make the reference
+counts atomic, so pointers to the same asset can be copied and dropped from
+multiple threads. Required by ConcurrentCacher.
+Other pools still need to be synchronized externally.
+*/
+
 } // namespace dynasma
 
 #endif // INCLUDED_DYNASMA_DEFINITIONS_H
\ No newline at end of file
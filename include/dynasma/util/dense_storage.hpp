@@ -0,0 +1,284 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_DENSE_STORAGE_H
+#define INCLUDED_DYNASMA_DENSE_STORAGE_H
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace dynasma {
+
+/**
+ * @brief How scattered the objects of a DenseStorage are
+ */
+struct FragmentationStats {
+    // number of stored objects
+    std::size_t objects;
+    // number of slots up to the last object, which iteration walks over
+    std::size_t spanned_slots;
+    // number of slots in all chunks
+    std::size_t capacity;
+
+    /**
+     * @returns the share of free slots among the spanned ones, 0 when packed
+     */
+    double ratio() const {
+        return spanned_slots == 0
+                   ? 0.0
+                   : double(spanned_slots - objects) / spanned_slots;
+    }
+};
+
+namespace internal {
+
+/**
+ * Chunks of slots for objects of one type, with the occupied slots tracked in
+ * a bitmask per chunk. Each occupied slot remembers an owner, set by the pool
+ */
+template <class T> class DenseChunks {
+  public:
+    static constexpr std::size_t CHUNK_SLOTS = 64;
+
+  private:
+    struct Chunk {
+        alignas(T) std::byte slots[CHUNK_SLOTS][sizeof(T)];
+        std::uint64_t occupied = 0;
+        void *owners[CHUNK_SLOTS];
+
+        T *slot(std::size_t i) { return reinterpret_cast<T *>(slots[i]); }
+    };
+
+    // in allocation order, which is the iteration order
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    // chunk starts sorted by address, with their chunk indices
+    std::vector<std::pair<const std::byte *, std::size_t>> m_by_address;
+    // no chunk before this one has a free slot
+    std::size_t m_first_free_chunk = 0;
+    std::size_t m_size = 0;
+
+    // the chunk index and slot index of the object
+    std::pair<std::size_t, std::size_t> locate(const T *p) const {
+        auto *p_byte = reinterpret_cast<const std::byte *>(p);
+        auto it = std::upper_bound(
+            m_by_address.begin(), m_by_address.end(), p_byte,
+            [](const std::byte *p, const auto &entry) {
+                return p < entry.first;
+            });
+        assert(it != m_by_address.begin() && "Not allocated by this storage");
+        std::size_t i = (p_byte - (it - 1)->first) / sizeof(T);
+        assert(i < CHUNK_SLOTS && "Not allocated by this storage");
+        return {(it - 1)->second, i};
+    }
+
+  public:
+    T *allocate() {
+        while (m_first_free_chunk < m_chunks.size() &&
+               m_chunks[m_first_free_chunk]->occupied == ~std::uint64_t(0)) {
+            m_first_free_chunk++;
+        }
+        if (m_first_free_chunk == m_chunks.size()) {
+            m_chunks.push_back(std::make_unique<Chunk>());
+            std::pair<const std::byte *, std::size_t> entry{
+                m_chunks.back()->slots[0], m_chunks.size() - 1};
+            m_by_address.insert(std::upper_bound(m_by_address.begin(),
+                                                 m_by_address.end(), entry),
+                                entry);
+        }
+        Chunk &chunk = *m_chunks[m_first_free_chunk];
+        std::size_t i = std::countr_one(chunk.occupied);
+        chunk.occupied |= std::uint64_t(1) << i;
+        chunk.owners[i] = nullptr;
+        m_size++;
+        return chunk.slot(i);
+    }
+
+    void deallocate(T *p) {
+        auto [c, i] = locate(p);
+        assert((m_chunks[c]->occupied >> i & 1) && "Double deallocation");
+        m_chunks[c]->occupied &= ~(std::uint64_t(1) << i);
+        m_size--;
+        m_first_free_chunk = std::min(m_first_free_chunk, c);
+    }
+
+    void set_owner(const T *p, void *p_owner) {
+        auto [c, i] = locate(p);
+        m_chunks[c]->owners[i] = p_owner;
+    }
+    void *owner(const T *p) const {
+        auto [c, i] = locate(p);
+        return m_chunks[c]->owners[i];
+    }
+
+    /**
+     * @returns the occupied slot iterated last, or nullptr if none is
+     */
+    T *last() const {
+        for (std::size_t c = m_chunks.size(); c-- > 0;) {
+            if (m_chunks[c]->occupied) {
+                std::size_t i = 63 - std::countl_zero(m_chunks[c]->occupied);
+                return m_chunks[c]->slot(i);
+            }
+        }
+        return nullptr;
+    }
+    /**
+     * @returns whether p_a comes before p_b in the iteration order
+     */
+    bool before(const T *p_a, const T *p_b) const {
+        return locate(p_a) < locate(p_b);
+    }
+
+    /**
+     * @brief Frees the empty chunks at the end
+     * @returns the number of freed chunks
+     */
+    std::size_t shrink() {
+        std::size_t count = 0;
+        while (!m_chunks.empty() && m_chunks.back()->occupied == 0) {
+            std::size_t c = m_chunks.size() - 1;
+            m_by_address.erase(std::find_if(
+                m_by_address.begin(), m_by_address.end(),
+                [c](const auto &entry) { return entry.second == c; }));
+            m_chunks.pop_back();
+            count++;
+        }
+        m_first_free_chunk = std::min(m_first_free_chunk, m_chunks.size());
+        return count;
+    }
+
+    FragmentationStats fragmentation() const {
+        std::size_t spanned = 0;
+        for (std::size_t c = m_chunks.size(); c-- > 0;) {
+            if (m_chunks[c]->occupied) {
+                spanned = c * CHUNK_SLOTS + CHUNK_SLOTS -
+                          std::countl_zero(m_chunks[c]->occupied);
+                break;
+            }
+        }
+        return FragmentationStats{m_size, spanned, capacity()};
+    }
+
+    /**
+     * @brief Calls fn(object, owner) for each occupied slot, chunk by chunk
+     */
+    template <class Fn> void for_each(Fn &&fn) {
+        for (auto &p_chunk : m_chunks) {
+            for (std::uint64_t bits = p_chunk->occupied; bits;
+                 bits &= bits - 1) {
+                std::size_t i = std::countr_zero(bits);
+                fn(*p_chunk->slot(i), p_chunk->owners[i]);
+            }
+        }
+    }
+
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_chunks.size() * CHUNK_SLOTS; }
+};
+
+} // namespace internal
+
+/**
+ * @brief An allocator storing its objects densely packed in chunks of 64
+ * slots, and tracking which slots are occupied. Freed slots are refilled
+ * from the first chunk with room.
+ * Pools detect it, to iterate their loaded assets chunk by chunk with
+ * for_each_loaded(), and to move the last cached asset into the slot of
+ * each unloaded one, keeping the assets packed. Holes left by assets that
+ * couldn't be moved then are closed by the pool's defragment()
+ * @note Allocates one object at a time. Copies share the storage
+ * @note Not thread-safe. With a DestructionQueue, drain it on the pool's
+ * thread. Assets destroyed through the queue leave holes, refilled later
+ */
+template <class T> class DenseStorage {
+    std::shared_ptr<internal::DenseChunks<T>> m_p_chunks;
+
+  public:
+    using value_type = T;
+
+    DenseStorage() : m_p_chunks(std::make_shared<internal::DenseChunks<T>>()) {}
+
+    T *allocate([[maybe_unused]] std::size_t n) {
+        assert(n == 1 && "DenseStorage allocates one object at a time");
+        return m_p_chunks->allocate();
+    }
+    void deallocate(T *p, [[maybe_unused]] std::size_t n) {
+        assert(n == 1 && "DenseStorage allocates one object at a time");
+        m_p_chunks->deallocate(p);
+    }
+
+    /**
+     * @brief Sets the owner of the object, i.e. its reference counter
+     */
+    void set_owner(const T *p, void *p_owner) {
+        m_p_chunks->set_owner(p, p_owner);
+    }
+    /**
+     * @returns the owner of the object, nullptr if none was set
+     */
+    void *owner(const T *p) const { return m_p_chunks->owner(p); }
+    /**
+     * @returns the object iterated last, or nullptr if there are none
+     */
+    T *last() const { return m_p_chunks->last(); }
+    /**
+     * @returns whether p_a is iterated before p_b
+     */
+    bool before(const T *p_a, const T *p_b) const {
+        return m_p_chunks->before(p_a, p_b);
+    }
+    /**
+     * @brief Frees the empty chunks at the end, which defragmentation leaves
+     * @returns the number of freed chunks
+     */
+    std::size_t shrink() { return m_p_chunks->shrink(); }
+    /**
+     * @brief Calls fn(object, owner) for each object, chunk by chunk
+     */
+    template <class Fn> void for_each(Fn &&fn) {
+        m_p_chunks->for_each(std::forward<Fn>(fn));
+    }
+
+    /**
+     * @returns the number of allocated objects
+     */
+    std::size_t size() const { return m_p_chunks->size(); }
+    /**
+     * @returns the number of slots in the chunks
+     */
+    std::size_t capacity() const { return m_p_chunks->capacity(); }
+    /**
+     * @returns how scattered the objects are
+     */
+    FragmentationStats fragmentation() const {
+        return m_p_chunks->fragmentation();
+    }
+
+    bool operator==(const DenseStorage &other) const {
+        return m_p_chunks == other.m_p_chunks;
+    }
+};
+
+/**
+ * An allocator that tracks its objects' owners and can be iterated, like
+ * DenseStorage
+ */
+template <class A>
+concept DenseStorageLike =
+    requires(A a, typename A::value_type *p, void *p_owner) {
+        a.set_owner(p, p_owner);
+        { a.owner(p) } -> std::convertible_to<void *>;
+        { a.last() } -> std::convertible_to<typename A::value_type *>;
+        { a.before(p, p) } -> std::convertible_to<bool>;
+        a.shrink();
+        a.for_each([](typename A::value_type &, void *) {});
+    };
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_DENSE_STORAGE_H
@@ -0,0 +1,106 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_EPOCHS_H
+#define INCLUDED_DYNASMA_EPOCHS_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace dynasma {
+
+/**
+ * @brief Epoch-based protection of memory read without locks.
+ * Readers wrap their accesses in a read section, writers unlink the memory
+ * they want to free and call synchronize() before freeing it. synchronize()
+ * waits until all read sections that could have seen the memory have ended.
+ * @note Read sections must be short and must not call synchronize()
+ */
+class EpochDomain {
+    // readers are spread over stripes to avoid sharing a cache line
+    static constexpr std::size_t STRIPE_COUNT = 16;
+
+    struct alignas(64) Stripe {
+        // readers in sections started during even and odd epochs
+        std::atomic<std::size_t> readers[2];
+    };
+
+    std::atomic<std::size_t> m_epoch;
+    Stripe m_stripes[STRIPE_COUNT];
+    std::mutex m_sync_mutex;
+
+    static std::size_t thread_stripe() {
+        static std::atomic<std::size_t> next_stripe{0};
+        thread_local std::size_t stripe =
+            next_stripe.fetch_add(1, std::memory_order_relaxed) % STRIPE_COUNT;
+        return stripe;
+    }
+
+  public:
+    /**
+     * @brief Keeps the memory read through the domain from being freed while
+     * it is alive
+     */
+    class ReadSection {
+        friend class EpochDomain;
+
+        std::atomic<std::size_t> *m_p_readers;
+
+        ReadSection(std::atomic<std::size_t> &readers)
+            : m_p_readers(&readers) {}
+
+      public:
+        ReadSection(const ReadSection &) = delete;
+        ReadSection &operator=(const ReadSection &) = delete;
+        ~ReadSection() { m_p_readers->fetch_sub(1, std::memory_order_release); }
+    };
+
+    EpochDomain() : m_epoch(0) {
+        for (Stripe &stripe : m_stripes) {
+            stripe.readers[0].store(0, std::memory_order_relaxed);
+            stripe.readers[1].store(0, std::memory_order_relaxed);
+        }
+    }
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    /**
+     * @brief Starts a read section, lasting until the returned object is
+     * destroyed
+     * @note Lock-free
+     */
+    [[nodiscard]] ReadSection read() {
+        Stripe &stripe = m_stripes[thread_stripe()];
+        for (;;) {
+            std::size_t epoch = m_epoch.load(std::memory_order_seq_cst);
+            std::atomic<std::size_t> &readers = stripe.readers[epoch & 1];
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (m_epoch.load(std::memory_order_seq_cst) == epoch) {
+                return ReadSection(readers);
+            }
+            // a writer started waiting for this epoch's readers; retry in
+            // the new one
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief Waits until all read sections started before this call have
+     * ended. Memory unlinked before the call can be freed afterwards
+     */
+    void synchronize() {
+        std::lock_guard lock(m_sync_mutex);
+        std::size_t parity =
+            m_epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+        for (Stripe &stripe : m_stripes) {
+            while (stripe.readers[parity].load(std::memory_order_acquire) !=
+                   0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_EPOCHS_H
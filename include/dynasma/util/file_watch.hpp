@@ -0,0 +1,174 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_FILE_WATCH_H
+#define INCLUDED_DYNASMA_FILE_WATCH_H
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace dynasma {
+
+/**
+ * @brief Calls callbacks when watched files change, to drive hot reloading.
+ * Changes are collected without blocking by poll(), which calls the
+ * callbacks on the polling thread
+ * @note On Linux the changes are reported by inotify. Elsewhere, poll()
+ * compares the files' modification times
+ * @example @code
+ *  FileWatcher watcher;
+ *  watcher.watch("shaders/lit.glsl", [&]() {
+ *      shaders.reload_if([](const ShaderSeed &seed) {
+ *          return seed.kernel == "shaders/lit.glsl";
+ *      });
+ *  });
+ *  ...
+ *  watcher.poll(); // once per frame
+ * @endcode
+ */
+class FileWatcher {
+  public:
+    using Callback = std::function<void()>;
+
+  private:
+    struct WatchedFile {
+        std::filesystem::path path;
+        Callback callback;
+        std::filesystem::file_time_type last_write;
+    };
+
+    std::vector<WatchedFile> m_files;
+
+    static std::filesystem::file_time_type
+    last_write_of(const std::filesystem::path &path) {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(path, ec);
+        return ec ? std::filesystem::file_time_type::min() : time;
+    }
+
+#ifdef __linux__
+    int m_fd;
+    // watch descriptors of the watched files' directories. Directories are
+    // watched instead of the files, as editors often replace files when
+    // saving them
+    std::map<int, std::filesystem::path> m_directories;
+
+    void watch_directory(const std::filesystem::path &directory) {
+        for (auto &[wd, path] : m_directories) {
+            if (path == directory) {
+                return;
+            }
+        }
+        int wd = inotify_add_watch(m_fd, directory.c_str(),
+                                   IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (wd < 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "inotify_add_watch failed");
+        }
+        m_directories[wd] = directory;
+    }
+#endif
+
+  public:
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    /**
+     * @throws std::system_error if the OS can't watch files
+     */
+    FileWatcher() {
+#ifdef __linux__
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd < 0) {
+            throw std::system_error(errno, std::generic_category(),
+                                    "inotify_init1 failed");
+        }
+#endif
+    }
+    ~FileWatcher() {
+#ifdef __linux__
+        close(m_fd);
+#endif
+    }
+
+    /**
+     * @brief Calls the callback from poll() each time the file changes
+     * @note The file's directory must exist
+     * @throws std::system_error if the directory can't be watched
+     */
+    void watch(const std::filesystem::path &path, Callback callback) {
+        std::filesystem::path absolute = std::filesystem::absolute(path);
+#ifdef __linux__
+        watch_directory(absolute.parent_path());
+#endif
+        m_files.push_back(WatchedFile{absolute, std::move(callback),
+                                      last_write_of(absolute)});
+    }
+
+    /**
+     * @brief Calls the callbacks of the files changed since the last call
+     * @returns the number of called callbacks
+     */
+    std::size_t poll() {
+        std::vector<std::size_t> changed;
+#ifdef __linux__
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t len = read(m_fd, buffer, sizeof(buffer));
+            if (len <= 0) {
+                break;
+            }
+            for (char *p = buffer; p < buffer + len;) {
+                auto *p_event = reinterpret_cast<inotify_event *>(p);
+                p += sizeof(inotify_event) + p_event->len;
+
+                auto dir_it = m_directories.find(p_event->wd);
+                if (p_event->len == 0 || dir_it == m_directories.end()) {
+                    continue;
+                }
+                std::filesystem::path path = dir_it->second / p_event->name;
+                for (std::size_t i = 0; i < m_files.size(); i++) {
+                    if (m_files[i].path == path) {
+                        changed.push_back(i);
+                    }
+                }
+            }
+        }
+#else
+        for (std::size_t i = 0; i < m_files.size(); i++) {
+            auto time = last_write_of(m_files[i].path);
+            if (time != m_files[i].last_write) {
+                m_files[i].last_write = time;
+                changed.push_back(i);
+            }
+        }
+#endif
+        // a save can report several events, call each callback once.
+        // Callbacks may watch more files, so the files are indexed
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < changed.size(); i++) {
+            bool duplicate = false;
+            for (std::size_t j = 0; j < i; j++) {
+                duplicate |= changed[j] == changed[i];
+            }
+            if (!duplicate) {
+                m_files[changed[i]].callback();
+                count++;
+            }
+        }
+        return count;
+    }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_FILE_WATCH_H
@@ -0,0 +1,246 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_HUGE_PAGE_ARENA_H
+#define INCLUDED_DYNASMA_HUGE_PAGE_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace dynasma {
+
+namespace internal {
+
+/**
+ * Large reserved regions of address space, backed by transparent huge pages,
+ * from which blocks are carved contiguously. The regions are committed in
+ * huge page steps as they fill up. Freed blocks are reused for blocks of the
+ * same size and alignment
+ */
+class HugePageArena {
+    static constexpr std::size_t HUGE_PAGE = std::size_t(2) << 20;
+    static constexpr std::size_t BLOCK_ALIGNMENT = 16;
+
+    struct Region {
+        std::byte *p_begin;
+        std::size_t reserved;
+        std::size_t committed;
+        std::size_t used;
+    };
+
+    std::size_t m_region_size;
+    std::mutex m_mutex;
+    std::vector<Region> m_regions;
+    // by size and alignment, as rebound copies share the arena
+    std::map<std::pair<std::size_t, std::size_t>, std::vector<std::byte *>>
+        m_free_blocks;
+    std::size_t m_used_memory = 0;
+
+    static std::size_t round_up(std::size_t n, std::size_t step) {
+        return (n + step - 1) / step * step;
+    }
+
+    void reserve_region(std::size_t min_size) {
+        std::size_t size =
+            round_up(std::max(m_region_size, min_size), HUGE_PAGE);
+#ifdef __linux__
+        // over-reserve to align the region to a huge page
+        void *p = mmap(nullptr, size + HUGE_PAGE, PROT_NONE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto *p_raw = static_cast<std::byte *>(p);
+        auto *p_begin = reinterpret_cast<std::byte *>(
+            round_up(reinterpret_cast<std::uintptr_t>(p_raw), HUGE_PAGE));
+        if (p_begin > p_raw) {
+            munmap(p_raw, p_begin - p_raw);
+        }
+        munmap(p_begin + size, p_raw + HUGE_PAGE - p_begin);
+        // only a hint, the kernel may not have huge pages enabled
+        madvise(p_begin, size, MADV_HUGEPAGE);
+        m_regions.push_back(Region{p_begin, size, 0, 0});
+#else
+        auto *p_begin = static_cast<std::byte *>(
+            ::operator new(size, std::align_val_t(BLOCK_ALIGNMENT)));
+        m_regions.push_back(Region{p_begin, size, size, 0});
+#endif
+    }
+
+    std::byte *carve(Region &region, std::size_t bytes,
+                     std::size_t alignment) {
+        std::size_t offset = round_up(region.used, alignment);
+        if (offset + bytes > region.reserved) {
+            return nullptr;
+        }
+        if (offset + bytes > region.committed) {
+            std::size_t committed = round_up(offset + bytes, HUGE_PAGE);
+#ifdef __linux__
+            if (mprotect(region.p_begin + region.committed,
+                         committed - region.committed,
+                         PROT_READ | PROT_WRITE) != 0) {
+                throw std::bad_alloc();
+            }
+#endif
+            region.committed = committed;
+        }
+        region.used = offset + bytes;
+        return region.p_begin + offset;
+    }
+
+    std::byte *take(std::size_t bytes, std::size_t alignment) {
+        auto it = m_free_blocks.find({bytes, alignment});
+        if (it != m_free_blocks.end() && !it->second.empty()) {
+            std::byte *p = it->second.back();
+            it->second.pop_back();
+            return p;
+        }
+        // the regions before the last one are full
+        if (!m_regions.empty()) {
+            if (std::byte *p = carve(m_regions.back(), bytes, alignment)) {
+                return p;
+            }
+        }
+        reserve_region(bytes + alignment);
+        if (bytes + alignment > m_region_size && m_regions.size() > 1) {
+            // a region of its own, keep filling the previous one
+            std::swap(m_regions.back(), m_regions[m_regions.size() - 2]);
+            return carve(m_regions[m_regions.size() - 2], bytes, alignment);
+        }
+        return carve(m_regions.back(), bytes, alignment);
+    }
+
+  public:
+    HugePageArena(std::size_t region_size) : m_region_size(region_size) {}
+    ~HugePageArena() {
+        for (Region &region : m_regions) {
+#ifdef __linux__
+            munmap(region.p_begin, region.reserved);
+#else
+            ::operator delete(region.p_begin,
+                              std::align_val_t(BLOCK_ALIGNMENT));
+#endif
+        }
+    }
+
+    void *allocate(std::size_t bytes, std::size_t alignment) {
+        alignment = std::max(alignment, BLOCK_ALIGNMENT);
+        bytes = round_up(bytes, alignment);
+        std::lock_guard lock(m_mutex);
+        std::byte *p = take(bytes, alignment);
+        m_used_memory += bytes;
+        return p;
+    }
+
+    void deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+        alignment = std::max(alignment, BLOCK_ALIGNMENT);
+        bytes = round_up(bytes, alignment);
+        std::lock_guard lock(m_mutex);
+        m_used_memory -= bytes;
+        m_free_blocks[{bytes, alignment}].push_back(
+            static_cast<std::byte *>(p));
+    }
+
+    std::size_t reserved_memory() {
+        std::lock_guard lock(m_mutex);
+        std::size_t total = 0;
+        for (const Region &region : m_regions) {
+            total += region.reserved;
+        }
+        return total;
+    }
+    std::size_t committed_memory() {
+        std::lock_guard lock(m_mutex);
+        std::size_t total = 0;
+        for (const Region &region : m_regions) {
+            total += region.committed;
+        }
+        return total;
+    }
+    std::size_t used_memory() {
+        std::lock_guard lock(m_mutex);
+        return m_used_memory;
+    }
+};
+
+} // namespace internal
+
+/**
+ * @brief An arena allocator placing its objects contiguously in regions
+ * backed by transparent huge pages, to reduce TLB misses when iterating many
+ * small assets.
+ * Address space is reserved a region at a time, and committed in 2 MB steps
+ * as the objects fill it. Freed objects' memory is reused for new objects,
+ * but stays committed until the last copy of the allocator is destroyed
+ * @note Copies share the arena. Huge pages are only requested with
+ * madvise(MADV_HUGEPAGE), so the kernel may still back the arena with small
+ * pages
+ * @example @code
+ *  HugePageArenaAllocator<Particle> arena;
+ *  BasicManager<ParticleSeed, HugePageArenaAllocator<Particle>> particles(
+ *      arena);
+ *  ...
+ *  std::cout << arena.committed_memory();
+ * @endcode
+ */
+template <class T> class HugePageArenaAllocator {
+    template <class U> friend class HugePageArenaAllocator;
+
+    std::shared_ptr<internal::HugePageArena> m_p_arena;
+
+  public:
+    using value_type = T;
+
+    /**
+     * @param region_size the amount of address space reserved at once
+     */
+    HugePageArenaAllocator(std::size_t region_size = std::size_t(1) << 30)
+        : m_p_arena(std::make_shared<internal::HugePageArena>(region_size)) {}
+    template <class U>
+    HugePageArenaAllocator(const HugePageArenaAllocator<U> &other)
+        : m_p_arena(other.m_p_arena) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(
+            m_p_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *p, std::size_t n) {
+        m_p_arena->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    /**
+     * @returns the number of bytes of reserved address space
+     */
+    std::size_t reserved_memory() const {
+        return m_p_arena->reserved_memory();
+    }
+    /**
+     * @returns the number of bytes of the reserved address space that can be
+     * backed by physical memory
+     */
+    std::size_t committed_memory() const {
+        return m_p_arena->committed_memory();
+    }
+    /**
+     * @returns the number of bytes taken by the allocated objects
+     */
+    std::size_t used_memory() const { return m_p_arena->used_memory(); }
+
+    template <class U>
+    bool operator==(const HugePageArenaAllocator<U> &other) const {
+        return m_p_arena == other.m_p_arena;
+    }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_HUGE_PAGE_ARENA_H
@@ -0,0 +1,322 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_NUMA_ALLOCATOR_H
+#define INCLUDED_DYNASMA_NUMA_ALLOCATOR_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace dynasma {
+
+/**
+ * @returns the number of NUMA nodes of the system, 1 if it can't be told
+ */
+inline int numaNodeCount() {
+    int count = 0;
+#ifdef __linux__
+    std::error_code ec;
+    for (auto &entry : std::filesystem::directory_iterator(
+             "/sys/devices/system/node", ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.starts_with("node") && name.size() > 4 &&
+            std::all_of(name.begin() + 4, name.end(),
+                        [](unsigned char c) { return std::isdigit(c); })) {
+            count++;
+        }
+    }
+#endif
+    return std::max(count, 1);
+}
+
+/**
+ * @returns the NUMA node of the CPU running the calling thread, 0 if it
+ * can't be told
+ */
+inline int currentNumaNode() {
+#ifdef __linux__
+    unsigned cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return static_cast<int>(node);
+    }
+#endif
+    return 0;
+}
+
+namespace internal {
+
+/**
+ * Slabs of memory placed on one NUMA node, shared by the copies of a
+ * NumaAllocator. Freed blocks are kept per slab and reused for blocks of
+ * the same size and alignment
+ */
+class NumaArena {
+    static constexpr std::size_t BLOCK_ALIGNMENT = 16;
+
+    struct Slab {
+        std::byte *p_begin;
+        std::size_t size;
+        std::size_t used;
+        // by size and alignment, as rebound copies share the slab
+        std::map<std::pair<std::size_t, std::size_t>, std::vector<std::byte *>>
+            free_blocks;
+
+        bool contains(const void *p) const {
+            auto *p_byte = static_cast<const std::byte *>(p);
+            return p_byte >= p_begin && p_byte < p_begin + size;
+        }
+        std::byte *take(std::size_t bytes, std::size_t alignment) {
+            auto it = free_blocks.find({bytes, alignment});
+            if (it != free_blocks.end() && !it->second.empty()) {
+                std::byte *p = it->second.back();
+                it->second.pop_back();
+                return p;
+            }
+            std::size_t offset = (used + alignment - 1) / alignment * alignment;
+            if (offset + bytes > size) {
+                return nullptr;
+            }
+            used = offset + bytes;
+            return p_begin + offset;
+        }
+    };
+
+    int m_node;
+    bool m_pinned;
+    std::size_t m_slab_size;
+    bool m_bound;
+    std::mutex m_mutex;
+    // sorted by address
+    std::vector<Slab> m_slabs;
+    std::size_t m_last_slab;
+
+    std::size_t slab_index_of(const void *p) const {
+        auto it = std::upper_bound(
+            m_slabs.begin(), m_slabs.end(), p,
+            [](const void *p, const Slab &slab) { return p < slab.p_begin; });
+        if (it == m_slabs.begin() || !(it - 1)->contains(p)) {
+            return m_slabs.size();
+        }
+        return it - 1 - m_slabs.begin();
+    }
+
+    std::size_t add_slab(std::size_t min_size) {
+        std::size_t size = std::max(m_slab_size, min_size);
+#ifdef __linux__
+        std::size_t page = sysconf(_SC_PAGESIZE);
+        size = (size + page - 1) / page * page;
+        void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        // bound before the pages are touched, so they're faulted in on the
+        // node. Preferred rather than strict, so a full node can't fail
+        // the allocation
+        unsigned long mask[4] = {};
+        if (m_node >= 0 && m_node < 256) {
+            mask[m_node / 64] = 1ul << (m_node % 64);
+            m_bound &= syscall(__NR_mbind, p, size, MPOL_PREFERRED, mask,
+                               sizeof(mask) * 8, 0) == 0;
+        } else {
+            m_bound = false;
+        }
+        if (m_pinned) {
+            // also faults the pages in
+            m_pinned &= mlock(p, size) == 0;
+        }
+#else
+        void *p = ::operator new(size, std::align_val_t(BLOCK_ALIGNMENT));
+        m_bound = false;
+        m_pinned = false;
+#endif
+        Slab slab{static_cast<std::byte *>(p), size, 0, {}};
+        auto it = std::upper_bound(m_slabs.begin(), m_slabs.end(),
+                                   slab.p_begin,
+                                   [](const std::byte *p, const Slab &slab) {
+                                       return p < slab.p_begin;
+                                   });
+        std::size_t index = it - m_slabs.begin();
+        m_slabs.insert(it, std::move(slab));
+        return index;
+    }
+
+    static std::size_t block_size(std::size_t bytes, std::size_t alignment) {
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+  public:
+    NumaArena(int node, bool pinned, std::size_t slab_size)
+        : m_node(node), m_pinned(pinned), m_slab_size(slab_size),
+          m_bound(true), m_last_slab(0) {}
+    ~NumaArena() {
+        for (Slab &slab : m_slabs) {
+#ifdef __linux__
+            munmap(slab.p_begin, slab.size);
+#else
+            ::operator delete(slab.p_begin, std::align_val_t(BLOCK_ALIGNMENT));
+#endif
+        }
+    }
+
+    /**
+     * @brief Allocates a block in p_hint's slab if it has room, otherwise
+     * next to the last allocated block
+     */
+    void *allocate(std::size_t bytes, std::size_t alignment,
+                   const void *p_hint) {
+        alignment = std::max(alignment, BLOCK_ALIGNMENT);
+        bytes = block_size(bytes, alignment);
+        std::lock_guard lock(m_mutex);
+
+        std::size_t hinted = p_hint ? slab_index_of(p_hint) : m_slabs.size();
+        for (std::size_t i : {hinted, m_last_slab}) {
+            if (i < m_slabs.size()) {
+                if (std::byte *p = m_slabs[i].take(bytes, alignment)) {
+                    m_last_slab = i;
+                    return p;
+                }
+            }
+        }
+        for (std::size_t i = 0; i < m_slabs.size(); i++) {
+            if (std::byte *p = m_slabs[i].take(bytes, alignment)) {
+                m_last_slab = i;
+                return p;
+            }
+        }
+        m_last_slab = add_slab(bytes + alignment);
+        return m_slabs[m_last_slab].take(bytes, alignment);
+    }
+
+    void deallocate(void *p, std::size_t bytes, std::size_t alignment) {
+        alignment = std::max(alignment, BLOCK_ALIGNMENT);
+        bytes = block_size(bytes, alignment);
+        std::lock_guard lock(m_mutex);
+        std::size_t i = slab_index_of(p);
+        if (i < m_slabs.size()) {
+            auto *p_block = static_cast<std::byte *>(p);
+            m_slabs[i].free_blocks[{bytes, alignment}].push_back(p_block);
+        }
+    }
+
+    int node() const { return m_node; }
+    bool is_bound() {
+        std::lock_guard lock(m_mutex);
+        return m_bound;
+    }
+    bool is_pinned() {
+        std::lock_guard lock(m_mutex);
+        return m_pinned;
+    }
+    std::size_t reserved_memory() {
+        std::lock_guard lock(m_mutex);
+        std::size_t total = 0;
+        for (const Slab &slab : m_slabs) {
+            total += slab.size;
+        }
+        return total;
+    }
+    bool share_slab(const void *p_a, const void *p_b) {
+        std::lock_guard lock(m_mutex);
+        std::size_t i = slab_index_of(p_a);
+        return i < m_slabs.size() && m_slabs[i].contains(p_b);
+    }
+};
+
+} // namespace internal
+
+/**
+ * @brief An allocator placing its objects in slabs on one NUMA node. Pass it
+ * to a pool's constructor to keep that pool's assets on the node of the
+ * threads using them.
+ * Takes locality hints, which pools use to place assets near the assets
+ * they depend on. Copies, also rebound ones, share the slabs, so pools of
+ * related assets can share an allocator to place them together
+ * @note The slabs are returned to the OS only when the last copy is destroyed
+ * @example @code
+ *  // on a 2-socket server, one manager per socket
+ *  using MeshManager = BasicManager<MeshSeed, NumaAllocator<Mesh>>;
+ *  MeshManager meshes0(NumaAllocator<Mesh>(0));
+ *  MeshManager meshes1(NumaAllocator<Mesh>(1));
+ * @endcode
+ */
+template <class T> class NumaAllocator {
+    template <class U> friend class NumaAllocator;
+
+    std::shared_ptr<internal::NumaArena> m_p_arena;
+
+  public:
+    using value_type = T;
+
+    /**
+     * @param node the NUMA node to place the objects on
+     * @param pinned whether the slabs are locked in physical memory
+     * @param slab_size the size of the slabs reserved at once
+     */
+    NumaAllocator(int node = currentNumaNode(), bool pinned = false,
+                  std::size_t slab_size = 1 << 21)
+        : m_p_arena(
+              std::make_shared<internal::NumaArena>(node, pinned, slab_size)) {}
+    template <class U>
+    NumaAllocator(const NumaAllocator<U> &other)
+        : m_p_arena(other.m_p_arena) {}
+
+    T *allocate(std::size_t n) { return allocate(n, nullptr); }
+    /**
+     * @brief Allocates near p_hint where possible
+     */
+    T *allocate(std::size_t n, const void *p_hint) {
+        return static_cast<T *>(
+            m_p_arena->allocate(n * sizeof(T), alignof(T), p_hint));
+    }
+    void deallocate(T *p, std::size_t n) {
+        m_p_arena->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    /**
+     * @returns the node the objects are placed on
+     */
+    int node() const { return m_p_arena->node(); }
+    /**
+     * @returns whether all slabs were bound to the node.
+     * False if the OS refused, in which case the objects are placed as usual
+     */
+    bool is_bound() const { return m_p_arena->is_bound(); }
+    /**
+     * @returns whether all slabs are locked in physical memory
+     */
+    bool is_pinned() const { return m_p_arena->is_pinned(); }
+    /**
+     * @returns the number of bytes reserved in slabs
+     */
+    std::size_t reserved_memory() const { return m_p_arena->reserved_memory(); }
+    /**
+     * @returns whether both objects were placed in the same slab
+     */
+    bool share_slab(const void *p_a, const void *p_b) const {
+        return m_p_arena->share_slab(p_a, p_b);
+    }
+
+    template <class U> bool operator==(const NumaAllocator<U> &other) const {
+        return m_p_arena == other.m_p_arena;
+    }
+};
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_NUMA_ALLOCATOR_H
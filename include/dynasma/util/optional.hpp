@@ -270,6 +270,25 @@ template <class PtrT> class OptionalPtrBase {
                            : std::optional<U>{};
     }
 
+    // Borrowing monadic operations, passing a FirmRef to the contained
+    // pointer instead of the pointer itself, so the callable can't cause any
+    // reference counting. Need dynasma/borrow.hpp
+
+    template <class F> auto and_then_borrowed(F &&f) const {
+        using R = std::remove_cvref_t<
+            std::invoke_result_t<F, decltype(borrow(m_value))>>;
+        return has_value() ? std::invoke(std::forward<F>(f), borrow(m_value))
+                           : R{};
+    }
+
+    template <class F> auto transform_borrowed(F &&f) const {
+        using U = std::remove_cv_t<
+            std::invoke_result_t<F, decltype(borrow(m_value))>>;
+        return has_value() ? std::optional<U>(std::invoke(std::forward<F>(f),
+                                                          borrow(m_value)))
+                           : std::optional<U>{};
+    }
+
     template <class F> std::optional<PtrT> or_else(F &&f) const & {
         if (has_value())
             return std::optional<PtrT>(m_value);
@@ -2,12 +2,41 @@
 #ifndef INCLUDED_DYNASMA_REF_MAN_H
 #define INCLUDED_DYNASMA_REF_MAN_H
 
+#include "dynasma/util/definitions.hpp"
+
 #include <cstdint>
+#include <vector>
+
+#ifdef DYNASMA_CONCURRENT_COUNTERS
+#include <atomic>
+#endif
 
 namespace dynasma {
 template <class T> class ReferenceCounter {
+#ifdef DYNASMA_CONCURRENT_COUNTERS
+    // the firm count while a transition to or from 0 is in progress
+    static constexpr std::size_t BUSY = (std::size_t)-1;
+    // the lazy count of a forgotten counter
+    static constexpr std::size_t DEAD = (std::size_t)-1;
+
+    std::atomic<std::size_t> m_firmcount;
+    std::atomic<std::size_t> m_lazycount;
+
+    void end_transition(std::size_t firmcount) {
+        m_firmcount.store(firmcount, std::memory_order_release);
+        m_firmcount.notify_all();
+    }
+    std::size_t wait_while_busy() {
+        std::size_t c;
+        while ((c = m_firmcount.load(std::memory_order_acquire)) == BUSY) {
+            m_firmcount.wait(BUSY, std::memory_order_acquire);
+        }
+        return c;
+    }
+#else
     std::size_t m_firmcount;
     std::size_t m_lazycount;
+#endif
 
   protected:
     T *p_obj;
@@ -28,30 +57,192 @@ template <class T> class ReferenceCounter {
      * @note Called only on the switch from unloadable to forgettable
      * @note this instance should not be referenced after this call
      * @note this instance can be deleted by this function, or after calling it
+     * @note With DYNASMA_CONCURRENT_COUNTERS, pools that let try_lazy_hold()
+     * revive counters must re-check with try_mark_forgotten()
      */
     virtual void handle_forgettable_impl() = 0;
 
+#ifdef DYNASMA_CONCURRENT_COUNTERS
+    /**
+     * @brief Raises the lazy reference count, unless the counter was
+     * forgotten. For pools that find counters without holding a reference
+     * @returns whether the count was raised
+     */
+    bool try_lazy_hold() {
+        std::size_t c = m_lazycount.load(std::memory_order_relaxed);
+        while (c != DEAD) {
+            if (m_lazycount.compare_exchange_weak(c, c + 1,
+                                                  std::memory_order_acquire)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    /**
+     * @brief Locks the counter while it isn't firmly held, so that the asset
+     * can be unloaded without racing a hold()
+     * @returns whether the counter was locked
+     */
+    bool try_lock_unused() {
+        std::size_t c = 0;
+        return m_firmcount.compare_exchange_strong(c, BUSY,
+                                                   std::memory_order_acquire);
+    }
+    void unlock_unused() { end_transition(0); }
+    /**
+     * @brief Marks the counter as forgotten if it isn't lazily held, after
+     * which try_lazy_hold() always fails
+     * @returns whether the counter was marked
+     */
+    bool try_mark_forgotten() {
+        std::size_t c = 0;
+        return m_lazycount.compare_exchange_strong(c, DEAD,
+                                                   std::memory_order_acq_rel);
+    }
+    /**
+     * @brief Drops what is likely the last lazy reference. Pools that free
+     * forgotten counters from other threads can override it to keep the
+     * counter alive until finish_lazy_release() returns
+     */
+    virtual void release_last_lazy() { finish_lazy_release(); }
+    void finish_lazy_release() {
+        if (m_lazycount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            handle_forgettable_impl();
+        }
+    }
+#endif
+
   public:
     ReferenceCounter() : m_firmcount(0), m_lazycount(0), p_obj(nullptr) {};
     virtual ~ReferenceCounter() {};
 
+    /**
+     * @brief Appends the counters of the assets this asset depends on, as
+     * declared by its seed
+     * @note Pools whose seeds are DependentSeedLike override this
+     */
+    virtual void collect_dependencies(std::vector<ReferenceCounter *> &) {}
+
+    /**
+     * @returns a stamp of the asset's version, which changes each time the
+     * pool replaces the asset with a newly constructed one
+     * @note Pools that can reload assets override this
+     */
+    virtual std::size_t version() const { return 0; }
+
     /**
      * @brief Raises the firm reference count
      * @note If the asset is not loaded, it will be loaded
      */
     void hold() {
+#ifdef DYNASMA_CONCURRENT_COUNTERS
+        std::size_t c = wait_while_busy();
+        for (;;) {
+            if (c == BUSY) {
+                c = wait_while_busy();
+            } else if (c > 0) {
+                if (m_firmcount.compare_exchange_weak(
+                        c, c + 1, std::memory_order_acquire)) {
+                    return;
+                }
+            } else if (m_firmcount.compare_exchange_weak(
+                           c, BUSY, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        // other holders wait until the asset is usable
+        try {
+            handle_usable_impl();
+        } catch (...) {
+            end_transition(0);
+            throw;
+        }
+        // the firm holders together hold one lazy reference, so that only
+        // the last lazy_release() can make the counter forgettable
+        m_lazycount.fetch_add(1, std::memory_order_relaxed);
+        end_transition(1);
+#else
         if (is_unloadable()) {
             m_firmcount++;
-            handle_usable_impl();
+            try {
+                handle_usable_impl();
+            } catch (...) {
+                m_firmcount--;
+                throw;
+            }
         } else {
             m_firmcount++;
         }
+#endif
+    }
+    /**
+     * @brief Raises the firm reference count only if the asset is loaded,
+     * i.e. used or cached
+     * @returns whether the count was raised
+     * @note Never loads the asset
+     */
+    bool try_hold() {
+#ifdef DYNASMA_CONCURRENT_COUNTERS
+        std::size_t c = wait_while_busy();
+        for (;;) {
+            if (c == BUSY) {
+                c = wait_while_busy();
+            } else if (c > 0) {
+                if (m_firmcount.compare_exchange_weak(
+                        c, c + 1, std::memory_order_acquire)) {
+                    return true;
+                }
+            } else if (m_firmcount.compare_exchange_weak(
+                           c, BUSY, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        // the asset can't be unloaded while we hold the transition
+        if (!is_loaded()) {
+            end_transition(0);
+            return false;
+        }
+        try {
+            handle_usable_impl();
+        } catch (...) {
+            end_transition(0);
+            throw;
+        }
+        m_lazycount.fetch_add(1, std::memory_order_relaxed);
+        end_transition(1);
+        return true;
+#else
+        if (!is_loaded()) {
+            return false;
+        }
+        hold();
+        return true;
+#endif
     }
     /**
      * @brief Reduces the firm reference count
      * @note If the count reaches 0, the asset can be unloaded
      */
     void release() {
+#ifdef DYNASMA_CONCURRENT_COUNTERS
+        std::size_t c = wait_while_busy();
+        for (;;) {
+            if (c == BUSY) {
+                c = wait_while_busy();
+            } else if (c > 1) {
+                if (m_firmcount.compare_exchange_weak(
+                        c, c - 1, std::memory_order_acq_rel)) {
+                    return;
+                }
+            } else if (m_firmcount.compare_exchange_weak(
+                           c, BUSY, std::memory_order_acq_rel)) {
+                break;
+            }
+        }
+        handle_unloadable_impl();
+        end_transition(0);
+        lazy_release();
+#else
         m_firmcount--;
         if (is_unloadable()) {
             handle_unloadable_impl();
@@ -59,6 +250,7 @@ template <class T> class ReferenceCounter {
                 handle_forgettable_impl();
             }
         }
+#endif
     }
     /**
      * @returns a pointer to the loaded asset or nullptr if the asset is
@@ -69,16 +261,33 @@ template <class T> class ReferenceCounter {
     /**
      * @brief Increases the lazy reference count
      */
-    void lazy_hold() { m_lazycount++; }
+    void lazy_hold() {
+#ifdef DYNASMA_CONCURRENT_COUNTERS
+        m_lazycount.fetch_add(1, std::memory_order_relaxed);
+#else
+        m_lazycount++;
+#endif
+    }
     /**
      * @brief Reduces the lazy reference count
      * @note If the count reaches 0, this instance can be deleted
      */
     void lazy_release() {
+#ifdef DYNASMA_CONCURRENT_COUNTERS
+        std::size_t c = m_lazycount.load(std::memory_order_relaxed);
+        while (c > 1) {
+            if (m_lazycount.compare_exchange_weak(c, c - 1,
+                                                  std::memory_order_release)) {
+                return;
+            }
+        }
+        release_last_lazy();
+#else
         m_lazycount--;
         if (is_forgettable()) {
             handle_forgettable_impl();
         }
+#endif
     }
 
     /**
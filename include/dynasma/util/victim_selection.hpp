@@ -0,0 +1,161 @@
+#pragma once
+#ifndef INCLUDED_DYNASMA_VICTIM_SELECTION_H
+#define INCLUDED_DYNASMA_VICTIM_SELECTION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+namespace dynasma {
+
+/**
+ * @brief An eviction candidate found by selectVictims()
+ */
+struct Victim {
+    std::uint64_t score;
+    std::uint32_t slot;
+};
+
+namespace internal {
+
+// Orders the candidate heap so that the lowest score is at the front
+inline bool victimScoreGreater(const Victim &a, const Victim &b) {
+    return a.score > b.score;
+}
+
+/**
+ * Keeps the k best candidates in a min-heap
+ */
+class VictimHeap {
+    Victim *m_p_out;
+    std::size_t m_k;
+    std::size_t m_size;
+
+  public:
+    VictimHeap(Victim *p_out, std::size_t k)
+        : m_p_out(p_out), m_k(k), m_size(0) {}
+
+    // scores must be higher than this to enter the heap
+    std::uint64_t threshold() const {
+        return m_size < m_k ? 0 : m_p_out[0].score;
+    }
+
+    void offer(std::uint64_t score, std::uint32_t slot) {
+        if (score <= threshold()) {
+            return;
+        }
+        if (m_size == m_k) {
+            std::pop_heap(m_p_out, m_p_out + m_size, victimScoreGreater);
+            m_size--;
+        }
+        m_p_out[m_size++] = Victim{score, slot};
+        std::push_heap(m_p_out, m_p_out + m_size, victimScoreGreater);
+    }
+
+    // sorts the candidates from the best to the worst
+    std::size_t finish() {
+        std::sort_heap(m_p_out, m_p_out + m_size, victimScoreGreater);
+        return m_size;
+    }
+};
+
+inline std::uint64_t victimScore(std::uint32_t weight, std::uint32_t last_use,
+                                 std::uint32_t now) {
+    return (std::uint64_t)(now - last_use + 1) * weight;
+}
+
+} // namespace internal
+
+/**
+ * @brief The largest weight selectVictims() accepts. Keeps the scores below
+ * 2^63, so they can be compared as signed 64-bit integers
+ */
+inline constexpr std::uint32_t MAX_VICTIM_WEIGHT = 0x7fffffff;
+
+/**
+ * @brief Finds the k entries with the highest eviction score, where the score
+ * is the entry's weight multiplied by its age (plus one).
+ * Entries with weight 0 are never selected.
+ * Uses AVX2 or SSE4.2 when the compiler targets them.
+ * @param weights the weight of each entry, i.e. its memory cost. At most
+ * MAX_VICTIM_WEIGHT
+ * @param last_uses the time at which each entry was last used
+ * @param n the number of entries
+ * @param now the current time
+ * @param p_out the array receiving at least k best candidates
+ * @param k the maximum number of candidates to find
+ * @returns the number of candidates found, stored in p_out from the best to
+ * the worst
+ */
+inline std::size_t selectVictims(const std::uint32_t *weights,
+                                 const std::uint32_t *last_uses, std::size_t n,
+                                 std::uint32_t now, Victim *p_out,
+                                 std::size_t k) {
+    if (k == 0) {
+        return 0;
+    }
+    internal::VictimHeap heap(p_out, k);
+    std::size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m128i vnow = _mm_set1_epi32((int)(now + 1));
+    for (; i + 4 <= n; i += 4) {
+        __m128i last = _mm_loadu_si128((const __m128i *)(last_uses + i));
+        __m128i weight = _mm_loadu_si128((const __m128i *)(weights + i));
+        __m256i age64 = _mm256_cvtepu32_epi64(_mm_sub_epi32(vnow, last));
+        __m256i weight64 = _mm256_cvtepu32_epi64(weight);
+        __m256i score = _mm256_mul_epu32(age64, weight64);
+
+        __m256i threshold = _mm256_set1_epi64x((long long)heap.threshold());
+        int mask = _mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpgt_epi64(score, threshold)));
+        if (mask) {
+            alignas(32) std::uint64_t scores[4];
+            _mm256_store_si256((__m256i *)scores, score);
+            for (int lane = 0; lane < 4; lane++) {
+                if (mask & (1 << lane)) {
+                    heap.offer(scores[lane], (std::uint32_t)(i + lane));
+                }
+            }
+        }
+    }
+#elif defined(__SSE4_2__)
+    const __m128i vnow = _mm_set1_epi32((int)(now + 1));
+    for (; i + 2 <= n; i += 2) {
+        __m128i last = _mm_loadl_epi64((const __m128i *)(last_uses + i));
+        __m128i weight = _mm_loadl_epi64((const __m128i *)(weights + i));
+        __m128i age64 = _mm_cvtepu32_epi64(_mm_sub_epi32(vnow, last));
+        __m128i weight64 = _mm_cvtepu32_epi64(weight);
+        __m128i score = _mm_mul_epu32(age64, weight64);
+
+        __m128i threshold = _mm_set1_epi64x((long long)heap.threshold());
+        int mask = _mm_movemask_pd(
+            _mm_castsi128_pd(_mm_cmpgt_epi64(score, threshold)));
+        if (mask) {
+            alignas(16) std::uint64_t scores[2];
+            _mm_store_si128((__m128i *)scores, score);
+            for (int lane = 0; lane < 2; lane++) {
+                if (mask & (1 << lane)) {
+                    heap.offer(scores[lane], (std::uint32_t)(i + lane));
+                }
+            }
+        }
+    }
+#endif
+
+    // the scalar fallback, and the remainder of the vectorized loops
+    for (; i < n; i++) {
+        heap.offer(internal::victimScore(weights[i], last_uses[i], now),
+                   (std::uint32_t)i);
+    }
+
+    return heap.finish();
+}
+
+} // namespace dynasma
+
+#endif // INCLUDED_DYNASMA_VICTIM_SELECTION_H